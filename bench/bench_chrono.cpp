@@ -0,0 +1,50 @@
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include "../src/json_print.hpp"
+#include "../src/json_print_chrono.hpp"
+
+// Usage: bench_chrono [records]
+// Compares printing timestamps natively against formatting them with strftime
+// into a temporary string first, for records a microsecond apart.
+
+template <typename F>
+static double seconds(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    size_t records = argc > 1 ? strtoull(argv[1], nullptr, 10) : 5000000;
+    auto start = std::chrono::system_clock::now();
+    char buffer[128];
+    size_t checksum = 0;
+
+    double native = seconds([&]() {
+        for (size_t i = 0; i < records; i++) {
+            auto time = start + std::chrono::microseconds(i);
+            json_sprint_c(buffer, sizeof(buffer), R"({"time": ?, "level": ?})", time, "info");
+            checksum += buffer[30];
+        }
+    });
+
+    double with_strftime = seconds([&]() {
+        for (size_t i = 0; i < records; i++) {
+            auto time = start + std::chrono::microseconds(i);
+            auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+            time_t second = static_cast<time_t>(milliseconds / 1000);
+            struct tm parts;
+            gmtime_r(&second, &parts);
+            char text[32];
+            size_t size = strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%S", &parts);
+            snprintf(text + size, sizeof(text) - size, ".%03dZ", static_cast<int>(milliseconds % 1000));
+            json_sprint_c(buffer, sizeof(buffer), R"({"time": ?, "level": ?})", text, "info");
+            checksum += buffer[30];
+        }
+    });
+
+    printf("native    %7.3fs %7.1f ns/record\n", native, native * 1e9 / records);
+    printf("strftime  %7.3fs %7.1f ns/record\n", with_strftime, with_strftime * 1e9 / records);
+    return checksum == 0;
+}
@@ -0,0 +1,56 @@
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "../src/json_print.hpp"
+#include "../src/json_print_compact.hpp"
+
+// Usage: bench_compact [records]
+// Built twice, as bench_inlined and bench_compact (with JP_COMPACT), to compare
+// the printing speed of the two modes. bench_build_time compares their code size.
+
+template <typename F>
+static double seconds(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    size_t records = argc > 1 ? strtoull(argv[1], nullptr, 10) : 5000000;
+    std::string name = "some name";
+    std::vector<int> values = { 1, 2, 3 };
+    char buffer[256];
+    size_t checksum = 0;
+
+    double numbers = seconds([&]() {
+        for (size_t i = 0; i < records; i++) {
+            json_sprint_c(buffer, sizeof(buffer), R"({"id": ?, "x": ?, "y": ?})", i, i * 0.5, -static_cast<int>(i));
+            checksum += buffer[8];
+        }
+    });
+
+    double strings = seconds([&]() {
+        for (size_t i = 0; i < records; i++) {
+            json_sprint_c(buffer, sizeof(buffer), R"({"name": ?, "kind": ?, "ok": ?})", name, "record", i % 2 == 0);
+            checksum += buffer[10];
+        }
+    });
+
+    double mixed = seconds([&]() {
+        for (size_t i = 0; i < records; i++) {
+            json_sprint_c(buffer, sizeof(buffer), R"({"id": ?{x}, "price": ?{.2f}, "values": ?})", i, i * 0.25, values);
+            checksum += buffer[8];
+        }
+    });
+
+#ifdef JP_COMPACT
+    printf("compact mode\n");
+#else
+    printf("inlined mode\n");
+#endif
+    printf("numbers  %7.1f ns/record\n", numbers * 1e9 / records);
+    printf("strings  %7.1f ns/record\n", strings * 1e9 / records);
+    printf("mixed    %7.1f ns/record\n", mixed * 1e9 / records);
+    return checksum == 0;
+}
@@ -0,0 +1,71 @@
+#include <chrono>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include "../src/json_print.hpp"
+#include "../src/json_print_direct.hpp"
+
+// Usage: bench_direct [records] [path]
+// Compares writing NDJSON records to a file with O_DIRECT against json_fprint, in
+// throughput and in how much of the file is left in the page cache.
+
+template <typename F>
+static double seconds(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+constexpr auto context = JsonPrint::compile("{\"id\": ?, \"name\": ?, \"value\": ?, \"tags\": ?}\n");
+
+template <typename Print>
+static void print_records(size_t records, Print&& print) {
+    std::vector<const char*> tags = { "alpha", "beta" };
+    for (size_t i = 0; i < records; i++)
+        print(i, i % 3 == 0 ? "three" : "other", i * 0.5, tags);
+}
+
+/** Size of the file, and how many bytes of it are in the page cache */
+static void report(const char* name, const char* path, double time) {
+    int fd = open(path, O_RDONLY);
+    struct stat status;
+    fstat(fd, &status);
+    size_t size = status.st_size;
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t resident = 0;
+    if (size != 0) {
+        void* map = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        std::vector<unsigned char> pages((size + page - 1) / page);
+        mincore(map, size, pages.data());
+        for (unsigned char p : pages)
+            resident += (p & 1) * page;
+        munmap(map, size);
+    }
+    close(fd);
+    printf("%-8s %7.3fs %7.1f MB/s   page cache %7.1f MB of %7.1f MB\n", 
+        name, time, size / 1e6 / time, resident / 1e6, size / 1e6);
+}
+
+int main(int argc, char** argv) {
+    size_t records = argc > 1 ? strtoull(argv[1], nullptr, 10) : 10000000;
+    const char* path = argc > 2 ? argv[2] : "bench_direct.json";
+
+    bool direct = true;
+    double direct_time = seconds([&]() {
+        JsonPrint::json_direct_writer writer(path);
+        direct = writer.is_direct();
+        print_records(records, [&](auto&&... args) { JsonPrint::json_direct_print(writer, context, args...); });
+    });
+    report(direct ? "O_DIRECT" : "fadvise", path, direct_time);
+
+    double stdio_time = seconds([&]() {
+        FILE* out = fopen(path, "w");
+        print_records(records, [&](auto&&... args) { JsonPrint::json_fprint(out, context, args...); });
+        fclose(out);
+    });
+    report("FILE*", path, stdio_time);
+    remove(path);
+}
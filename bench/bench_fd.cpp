@@ -0,0 +1,94 @@
+#include <chrono>
+#include <cstdlib>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "../src/json_print.hpp"
+#include "../src/json_print_fd.hpp"
+
+// Usage: bench_fd [records]
+// Compares printing NDJSON records through the file descriptor writer against 
+// json_fprint on a FILE*, to a file, a pipe and a Unix socket.
+
+template <typename F>
+static double seconds(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+constexpr auto context = JsonPrint::compile("{\"id\": ?, \"name\": ?, \"value\": ?, \"tags\": ?}\n");
+
+template <typename Print>
+static void print_records(size_t records, Print&& print) {
+    std::vector<const char*> tags = { "alpha", "beta" };
+    for (size_t i = 0; i < records; i++)
+        print(i, i % 3 == 0 ? "three" : "other", i * 0.5, tags);
+}
+
+/** Forks a process that reads everything from fds[0], and returns the pid */
+static pid_t drain(int fds[2]) {
+    pid_t child = fork();
+    if (child == 0) {
+        close(fds[1]);
+        char buffer[64 * 1024];
+        while (read(fds[0], buffer, sizeof(buffer)) > 0) {}
+        _exit(0);
+    }
+    close(fds[0]);
+    return child;
+}
+
+template <typename Open>
+static void compare(const char* name, size_t records, Open&& open) {
+    double fd_time = seconds([&]() {
+        pid_t child = -1;
+        int fd = open(child);
+        {
+            JsonPrint::json_fd_writer writer(fd);
+            print_records(records, [&](auto&&... args) { JsonPrint::json_fdprint(writer, context, args...); });
+        }
+        close(fd);
+        if (child > 0)
+            waitpid(child, nullptr, 0);
+    });
+
+    double file_time = seconds([&]() {
+        pid_t child = -1;
+        FILE* out = fdopen(open(child), "w");
+        print_records(records, [&](auto&&... args) { JsonPrint::json_fprint(out, context, args...); });
+        fclose(out);
+        if (child > 0)
+            waitpid(child, nullptr, 0);
+    });
+
+    printf("%-12s fd writer %7.3fs %7.0f records/s   FILE* %7.3fs %7.0f records/s\n", 
+        name, fd_time, records / fd_time, file_time, records / file_time);
+}
+
+int main(int argc, char** argv) {
+    size_t records = argc > 1 ? strtoull(argv[1], nullptr, 10) : 2000000;
+
+    compare("file", records, [](pid_t&) {
+        FILE* file = tmpfile();
+        int fd = dup(fileno(file));
+        fclose(file);
+        return fd;
+    });
+
+    compare("pipe", records, [](pid_t& child) {
+        int fds[2];
+        if (pipe(fds) != 0)
+            exit(1);
+        child = drain(fds);
+        return fds[1];
+    });
+
+    compare("unix socket", records, [](pid_t& child) {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+            exit(1);
+        child = drain(fds);
+        return fds[1];
+    });
+}
@@ -0,0 +1,49 @@
+#include <chrono>
+#include <cstdlib>
+#include "../src/json_print.hpp"
+#include "../src/json_print_parallel.hpp"
+
+// Usage: bench_parallel [vector size] [map size]
+// Prints the time to write a std::vector<double> and a std::unordered_map
+// to /dev/null, serially and with 1 to 32 threads.
+
+template <typename F>
+static double seconds(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template <typename T>
+static void bench(const char* name, FILE* out, const T& container) {
+    constexpr auto context = JsonPrint::compile("?");
+    double serial = seconds([&]() { JsonPrint::json_fprint(out, context, container); });
+    printf("%-14s serial     %8.3fs\n", name, serial);
+
+    for (unsigned threads : { 1u, 2u, 4u, 8u, 16u, 32u }) {
+        JsonPrint::json_worker_pool pool(threads);
+        JsonPrint::json_parallel_options options;
+        options.pool = &pool;
+        options.threshold = 0;
+        double parallel = seconds([&]() { JsonPrint::json_fprint(out, context, JsonPrint::json_parallel(container, options)); });
+        printf("%-14s %2u threads %8.3fs  %5.2fx\n", name, threads, parallel, serial / parallel);
+    }
+}
+
+int main(int argc, char** argv) {
+    size_t vector_size = argc > 1 ? strtoull(argv[1], nullptr, 10) : 10000000;
+    size_t map_size = argc > 2 ? strtoull(argv[2], nullptr, 10) : 1000000;
+    FILE* out = fopen("/dev/null", "w");
+
+    std::vector<double> values(vector_size);
+    for (size_t i = 0; i < values.size(); i++)
+        values[i] = i * 0.25;
+    bench("vector<double>", out, values);
+
+    std::unordered_map<std::string, int> map;
+    for (size_t i = 0; i < map_size; i++)
+        map["key" + std::to_string(i)] = static_cast<int>(i);
+    bench("unordered_map", out, map);
+
+    fclose(out);
+}
@@ -0,0 +1,69 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include "../src/json_print.hpp"
+#include "../src/json_print_rotate.hpp"
+
+// Usage: bench_rotate [records] [directory]
+// Compares the latency of printing records through the rotating writer against
+// json_fprint with files rotated inline (fflush, fsync, fclose, rename, fopen),
+// rotating every 16 MB.
+
+constexpr auto context = JsonPrint::compile("{\"id\": ?, \"name\": ?, \"value\": ?, \"tags\": ?}\n");
+constexpr unsigned long long max_size = 16 * 1024 * 1024;
+
+/** Prints the records, timing each one, and reports throughput and latency percentiles */
+template <typename Print>
+static void measure(const char* name, size_t records, Print&& print) {
+    std::vector<const char*> tags = { "alpha", "beta" };
+    std::vector<float> latencies(records);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < records; i++) {
+        auto before = std::chrono::steady_clock::now();
+        print(i, i % 3 == 0 ? "three" : "other", i * 0.5, tags);
+        latencies[i] = std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - before).count();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::sort(latencies.begin(), latencies.end());
+    printf("%-8s %7.3fs %8.0f records/s   p99.99 %7.2fus  max %9.2fus\n", name, seconds, records / seconds,
+        latencies[records * 9999 / 10000], latencies.back());
+}
+
+static void remove_files(const std::string& path) {
+    for (int i = 1; remove((path + "." + std::to_string(i)).c_str()) == 0; i++) {}
+}
+
+int main(int argc, char** argv) {
+    size_t records = argc > 1 ? strtoull(argv[1], nullptr, 10) : 5000000;
+    std::string path = std::string(argc > 2 ? argv[2] : ".") + "/bench_rotate.log";
+
+    {
+        JsonPrint::json_rotate_options options;
+        options.max_size = max_size;
+        JsonPrint::json_rotating_writer writer(path.c_str(), options);
+        measure("rotating", records, [&](auto&&... args) { JsonPrint::json_rotate_print(writer, context, args...); });
+    }
+    remove_files(path);
+
+    int index = 1;
+    std::string name = path + ".1.tmp";
+    FILE* out = fopen(name.c_str(), "w");
+    measure("inline", records, [&](auto&&... args) {
+        JsonPrint::json_fprint(out, context, args...);
+        if (static_cast<unsigned long long>(ftell(out)) >= max_size) {
+            fflush(out);
+            fsync(fileno(out));
+            fclose(out);
+            rename(name.c_str(), (path + "." + std::to_string(index)).c_str());
+            name = path + "." + std::to_string(++index) + ".tmp";
+            out = fopen(name.c_str(), "w");
+        }
+    });
+    fclose(out);
+    rename(name.c_str(), (path + "." + std::to_string(index)).c_str());
+    remove_files(path);
+}
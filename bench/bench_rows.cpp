@@ -0,0 +1,62 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "../src/json_print.hpp"
+#include "../src/json_print_rows.hpp"
+
+// Usage: bench_rows [rows] [path]
+// Prints struct-of-arrays columns as NDJSON to a file, with json_fprint_rows against
+// a loop calling json_fprint once per row
+
+template <typename F>
+static double seconds(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    size_t rows = argc > 1 ? strtoull(argv[1], nullptr, 10) : 2000000;
+    const char* path = argc > 2 ? argv[2] : "bench_rows.json";
+
+    std::vector<long long> timestamps(rows);
+    std::vector<double> values(rows);
+    std::vector<std::string> tags(rows);
+    for (size_t i = 0; i < rows; i++) {
+        timestamps[i] = 1700000000000LL + static_cast<long long>(i);
+        values[i] = i * 0.25;
+        tags[i] = "tag-" + std::to_string(i % 100);
+    }
+    constexpr auto row = JsonPrint::compile(R"({"ts": ?, "value": ?{.2f}, "tag": ?})");
+
+    FILE* file = fopen(path, "w");
+    if (file == nullptr) {
+        perror("fopen");
+        return 1;
+    }
+    double loop = seconds([&]() {
+        for (size_t i = 0; i < rows; i++) {
+            JsonPrint::json_fprint(file, row, timestamps[i], values[i], tags[i]);
+            fputc('\n', file);
+        }
+        fflush(file);
+    });
+    long loop_size = ftell(file);
+    fclose(file);
+
+    file = fopen(path, "w");
+    double columns = seconds([&]() {
+        JsonPrint::json_fprint_rows(file, row, timestamps, values, tags);
+        fflush(file);
+    });
+    long columns_size = ftell(file);
+    fclose(file);
+    remove(path);
+
+    printf("rows: %zu\n", rows);
+    printf("json_fprint loop   %7.1f ns/row\n", loop * 1e9 / rows);
+    printf("json_fprint_rows   %7.1f ns/row\n", columns * 1e9 / rows);
+    return loop_size != columns_size;
+}
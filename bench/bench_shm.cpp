@@ -0,0 +1,68 @@
+#include <chrono>
+#include <cstdlib>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "../src/json_print.hpp"
+#include "../src/json_print_shm.hpp"
+
+// Usage: bench_shm [records]
+// Compares handing NDJSON records to another process through a shared memory 
+// ring against writing them into a pipe.
+
+template <typename F>
+static double seconds(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+constexpr auto context = JsonPrint::compile("{\"id\": ?, \"name\": ?, \"value\": ?, \"tags\": ?}\n");
+
+template <typename Print>
+static void print_records(size_t records, Print&& print) {
+    std::vector<const char*> tags = { "alpha", "beta" };
+    for (size_t i = 0; i < records; i++)
+        print(i, i % 3 == 0 ? "three" : "other", i * 0.5, tags);
+}
+
+int main(int argc, char** argv) {
+    size_t records = argc > 1 ? strtoull(argv[1], nullptr, 10) : 2000000;
+    std::string name = "/json_print_bench_" + std::to_string(getpid());
+
+    double shm = seconds([&]() {
+        JsonPrint::json_shm_ring ring = JsonPrint::json_shm_ring::create(name.c_str(), 1 << 20);
+        JsonPrint::json_shm_ring::unlink(name.c_str());
+        pid_t child = fork();
+        if (child == 0) {
+            JsonPrint::json_shm_reader reader(ring);
+            size_t bytes = 0;
+            for (size_t i = 0; i < records; i++)
+                reader.read([&](const char*, size_t size) { bytes += size; });
+            _exit(bytes == 0);
+        }
+        JsonPrint::json_shm_writer writer(ring);
+        print_records(records, [&](auto&&... args) { JsonPrint::json_shm_print(writer, context, args...); });
+        waitpid(child, nullptr, 0);
+    });
+
+    double pipe_time = seconds([&]() {
+        int fds[2];
+        if (pipe(fds) != 0)
+            exit(1);
+        pid_t child = fork();
+        if (child == 0) {
+            close(fds[1]);
+            char buffer[64 * 1024];
+            while (read(fds[0], buffer, sizeof(buffer)) > 0) {}
+            _exit(0);
+        }
+        close(fds[0]);
+        FILE* out = fdopen(fds[1], "w");
+        print_records(records, [&](auto&&... args) { JsonPrint::json_fprint(out, context, args...); });
+        fclose(out);
+        waitpid(child, nullptr, 0);
+    });
+
+    printf("shared memory ring %7.3fs %7.0f records/s   pipe %7.3fs %7.0f records/s\n", 
+        shm, records / shm, pipe_time, records / pipe_time);
+}
@@ -0,0 +1,84 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "../src/json_print.hpp"
+#include "../src/json_print_fd.hpp"
+#include "../src/json_print_uring.hpp"
+
+// Usage: bench_uring [records]
+// Compares writing NDJSON records through io_uring against the synchronous file
+// descriptor writer, in throughput and in the latency of printing single records,
+// to a file and to a pipe.
+
+constexpr auto context = JsonPrint::compile("{\"id\": ?, \"name\": ?, \"value\": ?, \"tags\": ?}\n");
+
+/** Prints the records, timing each one, and reports throughput and latency percentiles */
+template <typename Writer, typename Print>
+static void measure(const char* name, size_t records, Writer& writer, Print&& print) {
+    std::vector<const char*> tags = { "alpha", "beta" };
+    std::vector<float> latencies(records);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < records; i++) {
+        auto before = std::chrono::steady_clock::now();
+        print(writer, i, i % 3 == 0 ? "three" : "other", i * 0.5, tags);
+        latencies[i] = std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - before).count();
+    }
+    writer.flush();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::sort(latencies.begin(), latencies.end());
+    printf("%-16s %7.3fs %8.0f records/s   p99 %6.2fus  p99.99 %7.2fus  max %8.2fus\n", name, seconds, records / seconds,
+        latencies[records * 99 / 100], latencies[records * 9999 / 10000], latencies.back());
+}
+
+template <typename Open>
+static void compare(const char* name, size_t records, Open&& open) {
+    std::string label;
+    pid_t child = -1;
+    int fd = open(child);
+    {
+        JsonPrint::json_uring_writer writer(fd);
+        label = std::string(name) + (writer.is_uring() ? " io_uring" : " fallback");
+        measure(label.c_str(), records, writer, [](JsonPrint::json_uring_writer& w, auto&&... args) { JsonPrint::json_uring_print(w, context, args...); });
+    }
+    close(fd);
+    if (child > 0)
+        waitpid(child, nullptr, 0);
+
+    fd = open(child);
+    {
+        JsonPrint::json_fd_writer writer(fd);
+        label = std::string(name) + " write";
+        measure(label.c_str(), records, writer, [](JsonPrint::json_fd_writer& w, auto&&... args) { JsonPrint::json_fdprint(w, context, args...); });
+    }
+    close(fd);
+    if (child > 0)
+        waitpid(child, nullptr, 0);
+}
+
+int main(int argc, char** argv) {
+    size_t records = argc > 1 ? strtoull(argv[1], nullptr, 10) : 2000000;
+
+    compare("file", records, [](pid_t&) {
+        FILE* file = tmpfile();
+        int fd = dup(fileno(file));
+        fclose(file);
+        return fd;
+    });
+
+    compare("pipe", records, [](pid_t& child) {
+        int fds[2];
+        if (pipe(fds) != 0)
+            exit(1);
+        child = fork();
+        if (child == 0) {
+            close(fds[1]);
+            char buffer[64 * 1024];
+            while (read(fds[0], buffer, sizeof(buffer)) > 0) {}
+            _exit(0);
+        }
+        close(fds[0]);
+        return fds[1];
+    });
+}
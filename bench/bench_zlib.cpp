@@ -0,0 +1,59 @@
+#include <chrono>
+#include <cstdlib>
+#include "../src/json_print.hpp"
+#include "../src/json_print_zlib.hpp"
+
+// Usage: bench_zlib [records]
+// Compares compressing NDJSON records while printing them against printing 
+// them to a temporary file and compressing the file afterwards.
+
+template <typename F>
+static double seconds(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+constexpr auto context = JsonPrint::compile("{\"id\": ?, \"name\": ?, \"value\": ?, \"tags\": ?}\n");
+
+template <typename Print>
+static void print_records(size_t records, Print&& print) {
+    std::vector<const char*> tags = { "alpha", "beta" };
+    for (size_t i = 0; i < records; i++)
+        print(i, i % 3 == 0 ? "three" : "other", i * 0.5, tags);
+}
+
+int main(int argc, char** argv) {
+    size_t records = argc > 1 ? strtoull(argv[1], nullptr, 10) : 2000000;
+    FILE* out = fopen("/dev/null", "w");
+    unsigned long long text_size = 0;
+
+    for (int level : { 1, 6 }) {
+        JsonPrint::json_gzip_options options;
+        options.level = level;
+
+        double one_pass = seconds([&]() {
+            JsonPrint::json_gzip_writer writer(out, options);
+            print_records(records, [&](auto&&... args) { JsonPrint::json_gzprint(writer, context, args...); });
+            writer.close();
+            text_size = writer.total_in();
+        });
+
+        double two_pass = seconds([&]() {
+            FILE* text = tmpfile();
+            print_records(records, [&](auto&&... args) { JsonPrint::json_fprint(text, context, args...); });
+            rewind(text);
+            JsonPrint::json_gzip_writer writer(out, options);
+            std::vector<char> buffer(64 * 1024);
+            for (size_t size; (size = fread(buffer.data(), 1, buffer.size(), text)) != 0;)
+                writer.write(buffer.data(), buffer.data() + size);
+            writer.close();
+            fclose(text);
+        });
+
+        double megabytes = text_size / 1e6;
+        printf("level %d  one pass %7.3fs %7.1f MB/s   print then compress %7.3fs %7.1f MB/s\n", 
+            level, one_pass, megabytes / one_pass, two_pass, megabytes / two_pass);
+    }
+    fclose(out);
+}
@@ -0,0 +1,61 @@
+# Usage: cmake -DCOMPILER=<c++ compiler> -DSOURCE_DIR=<repo root> -DBINARY_DIR=<dir> [-DSITES=2000] -P build_time.cmake
+# Generates a translation unit with SITES json_print_c call sites, then measures
+# how long it takes to compile and how large the object file is, in compact
+# mode and with a precompiled header.
+
+if(NOT SITES)
+    set(SITES 2000)
+endif()
+if(NOT FLAGS)
+    set(FLAGS -std=c++17 -O2)
+endif()
+
+# arguments of the same types, but as lvalues, rvalues and string literals of different lengths
+set(argument_types "i" "i + 1" "d" "\"a\"" "\"text\"" "s" "v" "b")
+list(LENGTH argument_types argument_type_count)
+
+# each site gets a distinct format string, with one to three placeholders
+set(source "#include \"json_print.hpp\"\n#ifdef JP_COMPACT\n#include \"json_print_compact.hpp\"\n#endif\n#include <string>\n#include <vector>\n\n")
+math(EXPR last "${SITES} - 1")
+foreach(i RANGE ${last})
+    math(EXPR placeholders "${i} % 3 + 1")
+    set(format "{\\\"site\\\": ${i}")
+    set(args "")
+    foreach(j RANGE 1 ${placeholders})
+        math(EXPR type "(${i} + ${j}) % ${argument_type_count}")
+        list(GET argument_types ${type} arg)
+        string(APPEND format ", \\\"v${j}\\\": ?")
+        string(APPEND args ", ${arg}")
+    endforeach()
+    string(APPEND source "void site_${i}(FILE* file, int i, double d, bool b, const std::string& s, const std::vector<int>& v) { json_fprint_c(file, \"${format}}\"${args}); }\n")
+endforeach()
+
+file(MAKE_DIRECTORY ${BINARY_DIR})
+file(WRITE ${BINARY_DIR}/build_time_sites.cpp "${source}")
+file(COPY ${SOURCE_DIR}/json_print/json_print.hpp ${SOURCE_DIR}/json_print/json_print_compact.hpp DESTINATION ${BINARY_DIR})
+
+function(measure name)
+    string(TIMESTAMP start "%s%f")
+    execute_process(
+        COMMAND ${COMPILER} ${FLAGS} ${ARGN} -I${BINARY_DIR} -c ${BINARY_DIR}/build_time_sites.cpp -o ${BINARY_DIR}/build_time_sites.o
+        RESULT_VARIABLE result)
+    string(TIMESTAMP end "%s%f")
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "${name}: compilation failed")
+    endif()
+    math(EXPR milliseconds "(${end} - ${start}) / 1000")
+    file(SIZE ${BINARY_DIR}/build_time_sites.o size)
+    message("${name}: ${SITES} sites compiled in ${milliseconds} ms, object size ${size} bytes")
+endfunction()
+
+measure("header")
+measure("compact mode" -DJP_COMPACT)
+
+# GCC picks up json_print.hpp.gch in place of json_print.hpp
+execute_process(
+    COMMAND ${COMPILER} ${FLAGS} -x c++-header ${BINARY_DIR}/json_print.hpp -o ${BINARY_DIR}/json_print.hpp.gch
+    RESULT_VARIABLE result)
+if(result EQUAL 0)
+    measure("precompiled header")
+    file(REMOVE ${BINARY_DIR}/json_print.hpp.gch)
+endif()
@@ -1,11 +1,16 @@
 #include <algorithm>
 #include <array>
+#include <cmath>
 #include <cstddef>
+#include <cstdint>
 #include <cstdio>
 #include <map>
+#include <memory>
 #include <stdexcept>
 #include <string>
 #include <string.h>
+#include <tuple>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -31,10 +36,43 @@
 #define JP_MAX_PLACEHOLDERS 14
 #endif
 
+/* The deepest nesting of arrays and objects that the parser accepts */
+#ifndef JP_MAX_NESTING
+#define JP_MAX_NESTING 256
+#endif
+
 /* CONSTEXPR PARSER */
 
 namespace JsonPrint {
 
+/**
+ * Formatting selected by a placeholder specifier, e.g. ?{.3f} or ?{x}
+ */
+struct json_print_spec {
+    /** 
+     * 'f', 'e' or 'g' for numbers, 'x' or 'X' for hexadecimal strings, 'm' for times as 
+     * milliseconds, 's' for a spread placeholder ("...?") of object members, or 0 for the 
+     * default formatting 
+     */
+    char type;
+
+    /** 
+     * Digits after the decimal point for 'f' and 'e', or significant digits for 'g'.
+     * For 's', whether the spread members are preceded (spread_comma_before) or 
+     * followed (spread_comma_after) by a ',' when there are any.
+     */
+    signed char precision;
+
+    /** Length of the placeholder in the format string, including the specifier */
+    unsigned char length;
+};
+
+/** json_print_spec::precision of a spread placeholder that comes after another member */
+constexpr signed char spread_comma_before = 1;
+
+/** json_print_spec::precision of a spread placeholder that comes first, before another member */
+constexpr signed char spread_comma_after = 2;
+
 /**
  * "Parsed" JSON format string structure
 */
@@ -48,26 +86,19 @@ struct json_print_context {
 
     /** Number of parts (or number of placeholders plus one) */
     size_t count;
+
+    /** Specifier of each placeholder */
+    json_print_spec specs[JP_MAX_PLACEHOLDERS];
 };
 
 namespace detail {
 
 constexpr bool is_whitespace(char c) {
-    switch (c) {
-        case JP_WHITESPACE:
-            return true;
-        default: 
-            return false;
-    }
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
 }
 
 constexpr bool is_decimal(char c) {
-    switch(c) {
-        case JP_DIGIT:
-            return true;
-        default:
-            return false;
-    }
+    return c >= '0' && c <= '9';
 }
 
 constexpr bool is_hexadecimal(char c) {
@@ -92,19 +123,34 @@ constexpr bool is_string_char(char c) {
     }
 }
 
+// The loops below count with an index instead of incrementing the pointer, which is
+// much cheaper for compilers to evaluate in constant expressions
+
 constexpr const char* skip_whitespace(const char* begin, const char* end) {
-    for (; begin != end && is_whitespace(*begin); begin++) {}
-    return begin;
+    size_t i = 0;
+    for (size_t size = end - begin; i != size && is_whitespace(begin[i]); i++) {}
+    return begin + i;
 }
 
 constexpr const char* skip_decimal(const char* begin, const char* end) {
-    for (; begin != end && is_decimal(*begin); begin++) {}
-    return begin;
+    size_t i = 0;
+    for (size_t size = end - begin; i != size && is_decimal(begin[i]); i++) {}
+    return begin + i;
+}
+
+/** Skips characters that don't need checking inside a string */
+constexpr const char* skip_string_chars(const char* begin, const char* end) {
+    size_t i = 0;
+    for (size_t size = end - begin; i != size && static_cast<unsigned char>(begin[i]) >= 0x20 && begin[i] != '"' && begin[i] != '\\'; i++) {}
+    return begin + i;
 }
 
 constexpr const char* parse_string(const char* begin, const char* end) {
     begin++; // skip opening quote
     while (begin != end) {
+        begin = skip_string_chars(begin, end);
+        if (begin == end)
+            break;
         switch(*begin) {
             case JP_CONTROL:
                 throw std::runtime_error("control characters not allowed inside strings");
@@ -144,7 +190,7 @@ constexpr const char* parse_string(const char* begin, const char* end) {
                 begin++;
         }
     }
-    return begin;
+    throw std::runtime_error(R"(expected '"', reached end of text)");
 }
 
 constexpr const char* parse_number(const char* begin, const char* end) {
@@ -200,39 +246,100 @@ constexpr const char* parse_number(const char* begin, const char* end) {
 }
 
 constexpr const char* parse_null(const char* begin, const char* end) {
-    if (end - begin < 4 && (
-        *(begin + 1) != 'u' || 
-        *(begin + 2) != 'l' || 
-        *(begin + 3) != 'l')) {
+    if (end - begin < 4 ||
+        begin[1] != 'u' ||
+        begin[2] != 'l' ||
+        begin[3] != 'l') {
         throw std::runtime_error("unrecognized token");
     }
     return begin + 4;
 }
 
 constexpr const char* parse_true(const char* begin, const char* end) {
-    if (end - begin < 4 && (
-        *(begin + 1) != 'r' || 
-        *(begin + 2) != 'u' || 
-        *(begin + 3) != 'e')) {
+    if (end - begin < 4 ||
+        begin[1] != 'r' ||
+        begin[2] != 'u' ||
+        begin[3] != 'e') {
         throw std::runtime_error("unrecognized token");
     }
     return begin + 4;
 }
 
 constexpr const char* parse_false(const char* begin, const char* end) {
-    if (end - begin < 5 && (
-        *(begin + 1) != 'a' || 
-        *(begin + 2) != 'l' || 
-        *(begin + 3) != 's' ||
-        *(begin + 4) != 'e')) {
+    if (end - begin < 5 ||
+        begin[1] != 'a' ||
+        begin[2] != 'l' ||
+        begin[3] != 's' ||
+        begin[4] != 'e') {
         throw std::runtime_error("unrecognized token");
     }
     return begin + 5;
 }
 
-constexpr const char* parse_value(const char* begin, const char* end, json_print_context& context);
+/**
+ * Parses a placeholder specifier: "{", an optional "." and precision, an optional type, and "}"
+ */
+constexpr const char* parse_spec(const char* begin, const char* end, json_print_spec& spec) {
+    begin++; // skip opening brace
+    spec.precision = -1;
+    if (begin != end && *begin == '.') {
+        begin++;
+        const char* digits = begin;
+        spec.precision = 0;
+        for (; begin != end && is_decimal(*begin); begin++)
+            spec.precision = static_cast<signed char>(spec.precision * 10 + (*begin - '0'));
+        if (begin == digits || begin - digits > 2)
+            throw std::runtime_error("expected precision of 0 to 99 digits");
+    }
+    if (begin == end)
+        throw std::runtime_error("expected '}'");
+    switch (*begin) {
+        case 'f':
+        case 'e':
+        case 'g':
+            spec.type = *begin++;
+            break;
+
+        case 'x':
+        case 'X':
+            if (spec.precision != -1)
+                throw std::runtime_error("hexadecimal specifier doesn't take a precision");
+            spec.type = *begin++;
+            break;
+
+        case 'm':
+            if (spec.precision != -1 || end - begin < 2 || begin[1] != 's')
+                throw std::runtime_error("expected 'ms'");
+            spec.type = 'm';
+            begin += 2;
+            break;
+
+        case '}':
+            // precision alone caps the significant digits
+            if (spec.precision == -1)
+                throw std::runtime_error("expected specifier type");
+            spec.type = 'g';
+            break;
+
+        default:
+            throw std::runtime_error("unrecognized specifier type");
+    }
+    if (begin == end || *begin != '}')
+        throw std::runtime_error("expected '}'");
+    return begin + 1;
+}
+
+/**
+ * Start of the literal part that follows a placeholder, or of the format string for the first part
+ */
+constexpr const char* part_begin(const json_print_context& context, size_t part) {
+    return part == 0 ? context.parts[0] : context.parts[part] + context.specs[part - 1].length;
+}
+
+/** Parses one value, with depth arrays and objects around it */
+constexpr const char* parse_value(const char* begin, const char* end, json_print_context& context, size_t depth = 0);
 
-constexpr const char* parse_array(const char* begin, const char* end, json_print_context& context) {
+constexpr const char* parse_array(const char* begin, const char* end, json_print_context& context, size_t depth) {
     begin++;
     begin = skip_whitespace(begin, end);
 
@@ -244,7 +351,7 @@ constexpr const char* parse_array(const char* begin, const char* end, json_print
 
     while (true) {
         // parse value
-        begin = parse_value(begin, end, context);
+        begin = parse_value(begin, end, context, depth);
 
         // parse ',' or ']'
         begin = skip_whitespace(begin, end);
@@ -258,7 +365,47 @@ constexpr const char* parse_array(const char* begin, const char* end, json_print
     }
 }
 
-constexpr const char* parse_object(const char* begin, const char* end, json_print_context& context) {
+/**
+ * Parses a spread placeholder "...?" in place of object members. The placeholder takes
+ * the ',' that separates it from the member before it, or else from the member after 
+ * it, so that nothing is left between the other members when there's nothing to spread.
+ * Returns the location of the ',' or '}' that follows, or of the next member when
+ * the ',' was taken.
+ */
+constexpr const char* parse_spread(const char* begin, const char* end, const char* comma, json_print_context& context) {
+    if (end - begin < 4 || begin[1] != '.' || begin[2] != '.' || begin[3] != '?')
+        throw std::runtime_error("expected '...?'");
+    if (context.count == JP_MAX_PLACEHOLDERS) // last slot is reserved for end
+        throw std::runtime_error("too many placeholder values");
+    context.count++;
+    const char* spread = begin;
+    const char* placeholder = comma != nullptr ? comma : spread;
+    context.parts[context.count] = placeholder;
+    json_print_spec& spec = context.specs[context.count - 1];
+    spec.type = 's';
+
+    begin = skip_whitespace(spread + 4, end);
+    if (begin == end)
+        throw std::runtime_error("expected ',' or '}', reached end of text");
+    if (*begin != ',' && *begin != '}')
+        throw std::runtime_error("expected ',' or '}'");
+    if (comma == nullptr && *begin == ',') {
+        // first member, so it takes the ',' after it, and a member must follow
+        begin = skip_whitespace(begin + 1, end);
+        if (begin == end || *begin != '"')
+            throw std::runtime_error(R"(expected '"' after a leading '...?')");
+        spec.precision = spread_comma_after;
+        spec.length = static_cast<unsigned char>(begin - placeholder);
+    } else {
+        spec.precision = comma != nullptr ? spread_comma_before : 0;
+        spec.length = static_cast<unsigned char>(spread + 4 - placeholder);
+    }
+    if (begin - placeholder > 255)
+        throw std::runtime_error("too much whitespace around '...?'");
+    return begin;
+}
+
+constexpr const char* parse_object(const char* begin, const char* end, json_print_context& context, size_t depth) {
     begin++;
     begin = skip_whitespace(begin, end);
 
@@ -267,45 +414,64 @@ constexpr const char* parse_object(const char* begin, const char* end, json_prin
         throw std::runtime_error(R"(expected '"' or '}', reached end of text)");
     if (*begin == '}')
         return begin + 1;
-    if (*begin != '"')
-        throw std::runtime_error(R"(expected '"' or '}')");
+    if (*begin != '"' && *begin != '.')
+        throw std::runtime_error(R"(expected '"', '...?' or '}')");
 
+    // the ',' before the current member, if any
+    const char* comma = nullptr;
     while (true) {
-        // parse member name
-        begin = parse_string(begin, end);
-        begin = skip_whitespace(begin, end);
-
-        // parse ':'
-        if (begin == end)
-            throw std::runtime_error("expected ':', reached end of text");
-        if (*begin != ':')
-            throw std::runtime_error("expected ':'");
-        begin++;
-        
-        // parse value
-        begin = parse_value(begin, end, context);
-        begin = skip_whitespace(begin, end);
+        if (*begin == '.') {
+            // a leading spread placeholder takes the ',' after it
+            begin = parse_spread(begin, end, comma, context);
+            if (*begin == '"')
+                continue;
+        } else {
+            // parse member name
+            begin = parse_string(begin, end);
+            begin = skip_whitespace(begin, end);
+
+            // parse ':'
+            if (begin == end)
+                throw std::runtime_error("expected ':', reached end of text");
+            if (*begin != ':')
+                throw std::runtime_error("expected ':'");
+            begin++;
+            
+            // parse value
+            begin = parse_value(begin, end, context, depth);
+            begin = skip_whitespace(begin, end);
+            if (begin == end)
+                throw std::runtime_error("expected ',' or '}', reached end of text");
+        }
 
         // parse ',' or '}'
-        if (begin == end)
-            throw std::runtime_error("expected ',' or '}', reached end of text");
         if (*begin == '}')
             return begin + 1;
         if (*begin != ',')
             throw std::runtime_error("expected ',' or '}'");
-        begin++;
+        comma = begin++;
         begin = skip_whitespace(begin, end);
+        if (begin == end)
+            throw std::runtime_error(R"(expected '"' or '...?', reached end of text)");
+        if (*begin != '"' && *begin != '.')
+            throw std::runtime_error(R"(expected '"' or '...?')");
     }
 }
 
-constexpr const char* parse_value(const char* begin, const char* end, json_print_context& context) {
+constexpr const char* parse_value(const char* begin, const char* end, json_print_context& context, size_t depth) {
     begin = skip_whitespace(begin, end);
+    if (begin == end)
+        throw std::runtime_error("expected value, reached end of text");
     switch(*begin) {
         case '[':
-            return parse_array(begin, end, context);
+            if (depth == JP_MAX_NESTING)
+                throw std::runtime_error("arrays and objects nested too deeply");
+            return parse_array(begin, end, context, depth + 1);
 
         case '{':
-            return parse_object(begin, end, context);
+            if (depth == JP_MAX_NESTING)
+                throw std::runtime_error("arrays and objects nested too deeply");
+            return parse_object(begin, end, context, depth + 1);
 
         case '\"':
             return parse_string(begin, end);
@@ -328,7 +494,13 @@ constexpr const char* parse_value(const char* begin, const char* end, json_print
                 throw std::runtime_error("too many placeholder values");
             context.count++;
             context.parts[context.count] = begin;
-            begin++;
+            {
+                json_print_spec& spec = context.specs[context.count - 1];
+                const char* placeholder = begin++;
+                if (begin != end && *begin == '{')
+                    begin = parse_spec(begin, end, spec);
+                spec.length = static_cast<unsigned char>(begin - placeholder);
+            }
             break;
 
         default:
@@ -366,6 +538,30 @@ constexpr json_print_context compile(const char (&format)[N]) {
 namespace JsonPrint {
 namespace detail {
 
+/** Size of the stack buffer that sinks format numbers into with snprintf */
+constexpr int printf_buffer_size = 128;
+
+/**
+ * Formats text with snprintf and passes it to write, as (begin, end). The text is
+ * formatted on the stack, or on the heap if it's longer, like "%.99f" of a large
+ * number. Returns the length of the text, or 0 if snprintf failed.
+ */
+template <typename Write, typename... T>
+inline int format_printf(Write write, const char* format, const T&... args) {
+    char text[printf_buffer_size];
+    int result = snprintf(text, sizeof(text), format, args...);
+    if (result <= 0)
+        return 0;
+    if (result < printf_buffer_size) {
+        write(text, text + result);
+        return result;
+    }
+    std::unique_ptr<char[]> long_text(new char[result + 1]);
+    snprintf(long_text.get(), result + 1, format, args...);
+    write(long_text.get(), long_text.get() + result);
+    return result;
+}
+
 struct string_buffer {
     char* begin;
     char* end;
@@ -390,10 +586,44 @@ inline int write_string_unsafe(string_buffer* buffer, const char* text) {
 template <typename... T>
 int write_printf(string_buffer* buffer, const char* format, T&&... args)
 {
-    int result = (std::min)(
-        snprintf(buffer->begin, buffer->end - buffer->begin, format, std::forward<T>(args)...), 
-        static_cast<int>(buffer->end - buffer->begin));
-    buffer->begin += result;
+    int available = static_cast<int>(buffer->end - buffer->begin);
+    int result = snprintf(buffer->begin, available, format, args...);
+    if (result < available) {
+        buffer->begin += (std::max)(result, 0);
+        return result;
+    }
+
+    // snprintf reserves the last byte for its terminator, so format on the side and copy what fits
+    return format_printf([buffer](const char* text, const char* text_end) { write_string(buffer, text, text_end); }, format, args...);
+}
+
+/* growable string buffer */
+
+inline void write_char(std::string* buffer, const char c) {
+    buffer->push_back(c);
+}
+
+inline int write_string(std::string* buffer, const char* begin, const char* end) {
+    buffer->append(begin, end);
+    return static_cast<int>(end - begin);
+}
+
+inline int write_string_unsafe(std::string* buffer, const char* text) {
+    return write_string(buffer, text, text + strlen(text));
+}
+
+template <typename... T>
+int write_printf(std::string* buffer, const char* format, T&&... args)
+{
+    char text[128];
+    int result = snprintf(text, sizeof(text), format, args...);
+    if (result < static_cast<int>(sizeof(text)))
+        return write_string(buffer, text, text + (std::max)(result, 0));
+
+    size_t size = buffer->size();
+    buffer->resize(size + result + 1);
+    snprintf(&(*buffer)[size], result + 1, format, args...);
+    buffer->resize(size + result);
     return result;
 }
 
@@ -427,25 +657,171 @@ int write_printf(FILE* f, const char* format, T&&... args)
 }
 }
 
+/* 
+ * UTF-8 handling of string arguments. JP_UTF8_POLICY and JP_ASCII_ONLY change the
+ * inline functions that print strings, so they must have the same value in every
+ * file of a program, or the linker keeps one of the versions for all of them. Use
+ * json_string<Policy, AsciiOnly> for arguments that need a different policy.
+ */
+#define JP_UTF8_PASSTHROUGH 0 /* copy bytes of 128 and above unchecked */
+#define JP_UTF8_REPLACE 1     /* replace invalid UTF-8 with U+FFFD */
+#define JP_UTF8_ESCAPE 2      /* escape each invalid byte as \u00XX */
+#define JP_UTF8_REJECT 3      /* throw std::runtime_error on invalid UTF-8 */
+
+#ifndef JP_UTF8_POLICY
+#define JP_UTF8_POLICY JP_UTF8_PASSTHROUGH
+#endif
+
+/* When non-zero, non-ASCII characters are printed as \uXXXX escapes */
+#ifndef JP_ASCII_ONLY
+#define JP_ASCII_ONLY 0
+#endif
+
 namespace JsonPrint {
 namespace detail {
 
+template <bool CheckUtf8 = false>
 inline bool is_special_character(const char c) {
-    return c < 32 || c == '\\' || c == '\"';
+    const unsigned char u = static_cast<unsigned char>(c);
+    return u < 32 || c == '\\' || c == '\"' || (CheckUtf8 && u >= 0x80);
+}
+
+/**
+ * Finds the first character that can't be copied into a JSON string as-is,
+ * including non-ASCII characters if CheckUtf8 is set. Checks 8 characters at 
+ * a time with word-sized bit operations before falling back to one character 
+ * at a time.
+ */
+template <bool CheckUtf8>
+inline const char* find_special_character(const char* begin, const char* end) {
+    const uint64_t ones = ~uint64_t(0) / 255;
+    const uint64_t highs = ones * 0x80;
+    for (; end - begin >= 8; begin += 8) {
+        uint64_t word;
+        memcpy(&word, begin, sizeof(word));
+        uint64_t quotes = word ^ (ones * '"');
+        uint64_t backslashes = word ^ (ones * '\\');
+        uint64_t special = 
+            ((word - ones * 32) & ~word) |               // bytes below 32
+            ((quotes - ones) & ~quotes) |                // '"' bytes
+            ((backslashes - ones) & ~backslashes) |      // '\' bytes
+            (CheckUtf8 ? word : 0);                      // bytes of 128 and above
+        if (special & highs)
+            break;
+    }
+    for (; begin != end && !is_special_character<CheckUtf8>(*begin); begin++) {}
+    return begin;
+}
+
+/**
+ * Decodes the UTF-8 sequence starting at begin, and returns its length.
+ * If the sequence is invalid, codepoint is set to -1 and the length of 
+ * the invalid part is returned.
+ */
+inline size_t decode_utf8(const char* begin, const char* end, long& codepoint) {
+    const unsigned char lead = static_cast<unsigned char>(*begin);
+    size_t length = 0;
+    unsigned char min = 0x80;
+    unsigned char max = 0xBF;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        length = 2;
+        codepoint = lead & 0x1F;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        length = 3;
+        codepoint = lead & 0x0F;
+        min = lead == 0xE0 ? 0xA0 : min; // overlong
+        max = lead == 0xED ? 0x9F : max; // surrogates
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        length = 4;
+        codepoint = lead & 0x07;
+        min = lead == 0xF0 ? 0x90 : min; // overlong
+        max = lead == 0xF4 ? 0x8F : max; // above U+10FFFF
+    } else {
+        codepoint = -1;
+        return 1;
+    }
+
+    for (size_t i = 1; i < length; i++) {
+        // a truncated sequence at the end isn't read past the end
+        if (begin + i == end) {
+            codepoint = -1;
+            return i;
+        }
+        const unsigned char c = static_cast<unsigned char>(begin[i]);
+        if (c < min || c > max) {
+            codepoint = -1;
+            return i;
+        }
+        codepoint = (codepoint << 6) | (c & 0x3F);
+        min = 0x80;
+        max = 0xBF;
+    }
+    return length;
 }
 
 template <typename Dest>
-void json_print_string(Dest dest, const char* begin, const char* end) {
-    write_char(dest, '"');
-    for (; begin != end; begin++) {
-        const char* c;
-        for (c = begin; c != end && !is_special_character(*c); c++) {};
+inline void json_print_unicode_escape(Dest dest, unsigned long codepoint) {
+    const char* digits = "0123456789abcdef";
+    if (codepoint > 0xFFFF) {
+        // encode as a surrogate pair
+        codepoint -= 0x10000;
+        json_print_unicode_escape(dest, 0xD800 + (codepoint >> 10));
+        json_print_unicode_escape(dest, 0xDC00 + (codepoint & 0x3FF));
+        return;
+    }
+    const char text[6] = { '\\', 'u', 
+        digits[(codepoint >> 12) & 0xF], digits[(codepoint >> 8) & 0xF], 
+        digits[(codepoint >> 4) & 0xF], digits[codepoint & 0xF] };
+    write_string(dest, text, text + sizeof(text));
+}
+
+/**
+ * Prints the non-ASCII UTF-8 sequence starting at begin according to 
+ * the UTF-8 policy, and returns the end of the sequence
+ */
+template <int Utf8Policy, bool AsciiOnly, typename Dest>
+inline const char* json_print_utf8(Dest dest, const char* begin, const char* end) {
+    long codepoint = -1;
+    size_t length = decode_utf8(begin, end, codepoint);
+    if (codepoint < 0) {
+        switch (Utf8Policy) {
+            case JP_UTF8_REPLACE:
+                if (AsciiOnly)
+                    json_print_unicode_escape(dest, 0xFFFD);
+                else
+                    write_string_unsafe(dest, "\xEF\xBF\xBD");
+                return begin + length;
+            case JP_UTF8_REJECT:
+                throw std::runtime_error("invalid UTF-8 in string");
+            default:
+                break;
+        }
+    }
+    
+    if (AsciiOnly && codepoint >= 0) {
+        json_print_unicode_escape(dest, codepoint);
+    } else if (codepoint < 0 && (AsciiOnly || Utf8Policy == JP_UTF8_ESCAPE)) {
+        // escape each invalid byte as the code point of the same value
+        for (const char* c = begin; c != begin + length; c++)
+            json_print_unicode_escape(dest, static_cast<unsigned char>(*c));
+    } else {
+        write_string(dest, begin, begin + length);
+    }
+    return begin + length;
+}
+
+/**
+ * Prints the characters of a JSON string, escaped but without the quotes
+ */
+template <int Utf8Policy = JP_UTF8_POLICY, bool AsciiOnly = JP_ASCII_ONLY, typename Dest>
+void json_print_escaped(Dest dest, const char* begin, const char* end) {
+    constexpr bool check_utf8 = Utf8Policy != JP_UTF8_PASSTHROUGH || AsciiOnly;
+    while (begin != end) {
+        const char* c = find_special_character<check_utf8>(begin, end);
         write_string(dest, begin, c);
 
         if (c == end)
             break;
-        if (c == end - 1 && *c == '\0')
-            break;
 
         switch(*c) {
             case '"':
@@ -470,12 +846,29 @@ void json_print_string(Dest dest, const char* begin, const char* end) {
                 write_string_unsafe(dest, R"(\t)");
                 break;
             default:
-                write_printf(dest, "\\%04u", static_cast<unsigned>(*c));
+                if (static_cast<unsigned char>(*c) >= 0x80) {
+                    begin = json_print_utf8<Utf8Policy, AsciiOnly>(dest, c, end);
+                    continue;
+                }
+                json_print_unicode_escape(dest, static_cast<unsigned char>(*c));
                 break;
         }
 
-        begin = c;
+        begin = c + 1;
     }
+}
+
+/**
+ * Prints a JSON string. The UTF-8 policy and ASCII-only mode default to the
+ * JP_UTF8_POLICY and JP_ASCII_ONLY configuration
+ */
+template <int Utf8Policy = JP_UTF8_POLICY, bool AsciiOnly = JP_ASCII_ONLY, typename Dest>
+void json_print_string(Dest dest, const char* begin, const char* end) {
+    // a trailing null terminator isn't printed
+    if (begin != end && *(end - 1) == '\0')
+        end--;
+    write_char(dest, '"');
+    json_print_escaped<Utf8Policy, AsciiOnly>(dest, begin, end);
     write_char(dest, '"');
 }
 
@@ -583,18 +976,60 @@ inline void json_print_arg(Dest dest, long double n) {
     json_print_float_arg(dest, n); 
 }
 
+/**
+ * String printed with a UTF-8 policy and ASCII-only mode of its own, rather than
+ * the JP_UTF8_POLICY and JP_ASCII_ONLY configuration
+ */
+template <int Utf8Policy, bool AsciiOnly>
+struct json_string_arg {
+    const char* begin;
+    const char* end;
+};
+
+template <typename Dest, int Utf8Policy, bool AsciiOnly>
+inline void json_print_arg(Dest dest, const json_string_arg<Utf8Policy, AsciiOnly>& n) {
+    json_print_string<Utf8Policy, AsciiOnly>(dest, n.begin, n.end);
+}
+
+/* elements */
+
+template <typename Dest, typename T>
+inline void json_print_spec_arg(Dest dest, const json_print_spec& spec, const T& n);
+
+/**
+ * Prints an element of a container or generator through json_print_spec_arg, so that
+ * the overloads of the optional headers, which are declared next to json_print_spec,
+ * are found for any sink
+ */
+template <typename Dest, typename T>
+inline void json_print_element(Dest dest, const T& n) {
+    json_print_spec_arg(dest, json_print_spec {}, n);
+}
+
+/* pair types */
+
+/** Pair printed as a JSON array of two elements, such as the members of a map */
+template <typename Dest, typename K, typename V>
+inline void json_print_arg(Dest dest, const std::pair<K, V>& n) {
+    write_char(dest, '[');
+    json_print_element(dest, n.first);
+    write_char(dest, ',');
+    json_print_element(dest, n.second);
+    write_char(dest, ']');
+}
+
 /* array types */
 
 template <typename Dest, typename T>
-inline void json_print_array_arg(Dest dest, T n) {
+inline void json_print_array_arg(Dest dest, const T& n) {
     write_char(dest, '[');
     auto it = n.begin();
     if (it != n.end()) {
-        json_print_arg(dest, *it++);
+        json_print_element(dest, *it++);
     }
     while (it != n.end()) {
         write_char(dest, ',');
-        json_print_arg(dest, *it++);
+        json_print_element(dest, *it++);
     }
     write_char(dest, ']');
 }
@@ -609,24 +1044,96 @@ inline void json_print_arg(Dest dest, const std::array<T, N>& n) {
     json_print_array_arg(dest, n);
 }
 
+/* lazy array types */
+
+/**
+ * Iterator pair printed as a JSON array, elements are read while printing
+ */
+template <typename It>
+struct json_range_arg {
+    It first;
+    It last;
+
+    It begin() const { return first; }
+    It end() const { return last; }
+};
+
+/**
+ * Callable printed as a JSON array. It is invoked once with an "emit"
+ * callable, and each value passed to "emit" is printed as an element.
+ */
+template <typename F>
+struct json_generator_arg {
+    mutable F generate;
+};
+
+template <typename Dest, typename It>
+inline void json_print_arg(Dest dest, const json_range_arg<It>& n) {
+    json_print_array_arg(dest, n);
+}
+
+template <typename Dest, typename F>
+inline void json_print_arg(Dest dest, const json_generator_arg<F>& n) {
+    bool first = true;
+    write_char(dest, '[');
+    n.generate([&](const auto& item) {
+        if (!first)
+            write_char(dest, ',');
+        first = false;
+        json_print_element(dest, item);
+    });
+    write_char(dest, ']');
+}
+
+/* raw JSON */
+
+/**
+ * JSON text that has already been serialized, printed as it is
+ */
+struct json_raw_arg {
+    const char* begin;
+    const char* end;
+    bool validated = false; // set by json_raw_validated, so converters don't check it again
+};
+
+template <typename Dest>
+inline void json_print_arg(Dest dest, const json_raw_arg& n) {
+    write_string(dest, n.begin, n.end);
+}
+
+/**
+ * Validates the structure of raw JSON text with the format string parser, which
+ * doesn't decode strings or numbers
+ */
+inline void validate_raw(const char* begin, const char* end) {
+    json_print_context context = { 0 };
+    if (skip_whitespace(begin, end) == end)
+        throw std::runtime_error("expected value, reached end of text");
+    begin = parse_value(begin, end, context);
+    if (context.count != 0)
+        throw std::runtime_error("unexpected placeholder in raw JSON");
+    if (skip_whitespace(begin, end) != end)
+        throw std::runtime_error("expected end of text, reached additional content");
+}
+
 /* object types */
 
 template <typename Dest, typename T>
-inline void json_print_object_arg(Dest dest, T n)
+inline void json_print_object_arg(Dest dest, const T& n)
 {
     write_char(dest, '{');
     auto it = n.begin();
     if (it != n.end()) {
         json_print_arg(dest, it->first);
         write_char(dest, ':');
-        json_print_arg(dest, it->second);
+        json_print_element(dest, it->second);
         it++;
     }
     while (it != n.end()) {
         write_char(dest, ',');
         json_print_arg(dest, it->first);
         write_char(dest, ':');
-        json_print_arg(dest, it->second);
+        json_print_element(dest, it->second);
         it++;
     }
     write_char(dest, '}');
@@ -672,20 +1179,331 @@ inline void json_print_arg(Dest dest, const std::unordered_map<std::string_view,
 }
 #endif
 
+/* placeholder specifiers */
+
+/** Whether a specifier applies to arguments of type T */
+template <typename T>
+using is_spec_number = std::integral_constant<bool,
+    std::is_arithmetic<T>::value && !std::is_same<T, bool>::value && !std::is_same<T, char>::value>;
+
+template <typename Dest, typename T>
+inline void json_print_hex_arg(Dest dest, char type, T n, std::true_type) {
+    // negative numbers are printed as their two's complement, like printf
+    unsigned long long bits = static_cast<typename std::make_unsigned<T>::type>(n);
+    write_printf(dest, type == 'x' ? "\"%llx\"" : "\"%llX\"", bits);
+}
+
+template <typename Dest, typename T>
+inline void json_print_hex_arg(Dest dest, char, T n, std::false_type) {
+    json_print_arg(dest, n);
+}
+
+template <typename Dest, typename T>
+inline void json_print_spec_number(Dest dest, const json_print_spec& spec, T n) {
+    if (spec.type == 'x' || spec.type == 'X') {
+        json_print_hex_arg(dest, spec.type, n, std::is_integral<T> {});
+        return;
+    }
+    double value = static_cast<double>(n);
+    if (std::isnan(value) || std::isinf(value))
+        json_print_arg(dest, nullptr);
+    else if (spec.type == 'f')
+        write_printf(dest, "%.*f", spec.precision == -1 ? 6 : spec.precision, value);
+    else if (spec.type == 'e')
+        write_printf(dest, "%.*e", spec.precision == -1 ? 6 : spec.precision, value);
+    else
+        write_printf(dest, "%.*g", spec.precision == -1 ? 6 : spec.precision, value);
+}
+
+template <typename Dest, typename T>
+inline void json_print_spec_arg(Dest dest, const json_print_spec& spec, const T& n, std::true_type) {
+    if (spec.type == 0 || spec.type == 'm')
+        json_print_arg(dest, n);
+    else
+        json_print_spec_number(dest, spec, n);
+}
+
+template <typename Dest, typename T>
+inline void json_print_spec_arg(Dest dest, const json_print_spec&, const T& n, std::false_type) {
+    // specifiers only apply to numbers
+    json_print_arg(dest, n);
+}
+
+/* spread placeholders */
+
+/** Whether K can be printed as a member name, like the keys of map arguments */
+template <typename K>
+struct is_string_key : std::integral_constant<bool, 
+    std::is_same<K, const char*>::value || std::is_same<K, char*>::value || std::is_same<K, std::string>::value> {};
+
+#ifdef __cpp_lib_string_view
+template <>
+struct is_string_key<std::string_view> : std::true_type {};
+#endif
+
+/** Whether T holds key-value pairs with string keys, like a map or a range of pairs */
+template <typename T, typename = void>
+struct is_spreadable : std::false_type {};
+
+template <typename T>
+struct is_spreadable<T, decltype(void(std::declval<const T&>().begin()->second))> 
+    : is_string_key<typename std::decay<decltype(std::declval<const T&>().begin()->first)>::type> {};
+
+template <typename Dest, typename T>
+inline void json_print_spread_arg(Dest dest, const json_print_spec& spec, const T& n, std::true_type) {
+    // members are printed like those of a map, with the ',' taken from the format string
+    bool first = true;
+    for (const auto& member : n) {
+        if (!first || spec.precision == spread_comma_before)
+            write_char(dest, ',');
+        first = false;
+        json_print_arg(dest, member.first);
+        write_char(dest, ':');
+        json_print_element(dest, member.second);
+    }
+    if (!first && spec.precision == spread_comma_after)
+        write_char(dest, ',');
+}
+
+template <typename Dest, typename T>
+inline void json_print_spread_arg(Dest, const json_print_spec&, const T&, std::false_type) {
+    // only reached when the format string isn't a constant, otherwise spreads_match rejects it
+    throw std::runtime_error("expected a map or a range of pairs with string keys for '...?'");
+}
+
+/**
+ * Whether every spread placeholder of a format string has an argument that can be
+ * spread. Printing macros and the C++20 API check this at compile-time.
+ */
+template <typename... Ts>
+constexpr bool spreads_match(const json_print_context& context) {
+    // leading element, so the array isn't empty without arguments
+    constexpr bool spreadable[] = { true, is_spreadable<typename std::decay<Ts>::type>::value... };
+    for (size_t i = 0; i < sizeof...(Ts) && i + 1 < context.count; i++) {
+        if (context.specs[i].type == 's' && !spreadable[i + 1])
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Prints a placeholder argument with its specifier. The specifier of a compiled
+ * format string is a constant, so the branches are resolved when inlined.
+ */
+template <typename Dest, typename T>
+inline void json_print_spec_arg(Dest dest, const json_print_spec& spec, const T& n) {
+    if (spec.type == 's')
+        json_print_spread_arg(dest, spec, n, is_spreadable<T> {});
+    else
+        json_print_spec_arg(dest, spec, n, is_spec_number<T> {});
+}
+
 template <typename Dest>
 inline void json_print_part(Dest dest, const char* begin, const char* end) {
+    // format strings compiled with their null terminator end with '\0', which isn't printed
+    if (begin != end && *(end - 1) == '\0')
+        end--;
     write_string(dest, begin, end);
 }
 
 }
 
+/**
+ * Wraps an iterator pair as a placeholder argument, printed as a JSON array 
+ * without copying the elements into a container first
+ */
+template <typename It>
+inline detail::json_range_arg<It> json_range(It first, It last) {
+    return { first, last };
+}
+
+/**
+ * Wraps a generator as a placeholder argument, printed as a JSON array.
+ * The generator is called with an "emit" callable, and produces elements 
+ * on demand by calling it once per element.
+ */
+template <typename F>
+inline detail::json_generator_arg<F> json_generator(F generate) {
+    return { std::move(generate) };
+}
+
+/**
+ * Wraps a string as a placeholder argument, printed with the given UTF-8 policy and
+ * ASCII-only mode instead of the JP_UTF8_POLICY and JP_ASCII_ONLY configuration. 
+ * The text isn't copied.
+ */
+template <int Utf8Policy, bool AsciiOnly = false>
+inline detail::json_string_arg<Utf8Policy, AsciiOnly> json_string(const char* begin, const char* end) {
+    return { begin, end };
+}
+
+template <int Utf8Policy, bool AsciiOnly = false>
+inline detail::json_string_arg<Utf8Policy, AsciiOnly> json_string(const char* text) {
+    return { text, text + strlen(text) };
+}
+
+template <int Utf8Policy, bool AsciiOnly = false>
+inline detail::json_string_arg<Utf8Policy, AsciiOnly> json_string(const std::string& text) {
+    return { text.data(), text.data() + text.size() };
+}
+
+#ifdef __cpp_lib_string_view
+template <int Utf8Policy, bool AsciiOnly = false>
+inline detail::json_string_arg<Utf8Policy, AsciiOnly> json_string(std::string_view text) {
+    return { text.data(), text.data() + text.size() };
+}
+#endif
+
+/**
+ * Wraps JSON text that has already been serialized as a placeholder argument, 
+ * copied into the output as it is with a single write. The text isn't validated,
+ * and must stay valid until it's printed.
+ */
+inline detail::json_raw_arg json_raw(const char* begin, const char* end) {
+    return { begin, end };
+}
+
+inline detail::json_raw_arg json_raw(const char* text) {
+    return { text, text + strlen(text) };
+}
+
+inline detail::json_raw_arg json_raw(const std::string& text) {
+    return { text.data(), text.data() + text.size() };
+}
+
+#ifdef __cpp_lib_string_view
+inline detail::json_raw_arg json_raw(std::string_view text) {
+    return { text.data(), text.data() + text.size() };
+}
+#endif
+
+/**
+ * Like json_raw, but first checks that the text is a single valid JSON value
+ * @throws std::runtime_error if the text isn't valid JSON
+ */
+inline detail::json_raw_arg json_raw_validated(const char* begin, const char* end) {
+    detail::validate_raw(begin, end);
+    return { begin, end, true };
+}
+
+inline detail::json_raw_arg json_raw_validated(const char* text) {
+    return json_raw_validated(text, text + strlen(text));
+}
+
+inline detail::json_raw_arg json_raw_validated(const std::string& text) {
+    return json_raw_validated(text.data(), text.data() + text.size());
+}
+
+#ifdef __cpp_lib_string_view
+inline detail::json_raw_arg json_raw_validated(std::string_view text) {
+    return json_raw_validated(text.data(), text.data() + text.size());
+}
+#endif
+
 }
 
+/* C++20 API, with the format string as a template argument */
+
+#if defined(__cpp_nontype_template_args) && __cpp_nontype_template_args >= 201911L
+
 namespace JsonPrint {
 namespace detail {
 
-template <typename Dest, size_t... Is, typename... Ts>
-inline void json_print(Dest dest, const json_print_context& context, std::index_sequence<Is...>, Ts&&... args) {
+/**
+ * String literal that can be used as a template argument
+ */
+template <size_t N>
+struct fixed_string {
+    char text[N];
+
+    constexpr fixed_string(const char (&format)[N]) {
+        for (size_t i = 0; i < N; i++)
+            text[i] = format[i];
+    }
+};
+
+/**
+ * Format string parsed at compile-time, with each literal part as a constant
+ */
+template <fixed_string Format>
+struct static_format {
+    static constexpr json_print_context context = compile(Format.text, Format.text + sizeof(Format.text) - 1);
+
+    /** Number of placeholders */
+    static constexpr size_t placeholders = context.count - 1;
+
+    template <size_t I>
+    static constexpr const char* part_begin = detail::part_begin(context, I);
+
+    template <size_t I>
+    static constexpr size_t part_size = context.parts[I + 1] - part_begin<I>;
+};
+
+template <fixed_string Format, size_t I, typename Dest>
+inline void json_print_static_part(Dest dest) {
+    using format = static_format<Format>;
+    // the size is a constant, so short parts are written with fixed-size copies
+    if constexpr (format::template part_size<I> > 0)
+        write_string(dest, format::template part_begin<I>, format::template part_begin<I> + format::template part_size<I>);
+}
+
+template <fixed_string Format, typename Dest, size_t... Is, typename... Ts>
+inline void json_print_static(Dest dest, std::index_sequence<Is...>, const Ts&... args) {
+    static_assert(sizeof...(Ts) == static_format<Format>::placeholders, 
+        "number of arguments must match the number of placeholders");
+    static_assert(spreads_match<Ts...>(static_format<Format>::context),
+        "expected a map or a range of pairs with string keys for '...?'");
+    json_print_static_part<Format, 0>(dest);
+    ((json_print_spec_arg(dest, static_format<Format>::context.specs[Is], args), json_print_static_part<Format, Is + 1>(dest)), ...);
+}
+
+}
+
+/**
+ * Prints JSON text to the console. The format string is validated at compile-time,
+ * and the number of arguments must match the number of placeholders.
+ */
+template <detail::fixed_string Format, typename... Ts>
+inline void print(const Ts&... args) {
+    detail::json_print_static<Format>(stdout, std::index_sequence_for<Ts...> {}, args...);
+}
+
+/**
+ * Writes JSON text to a file. The format string is validated at compile-time,
+ * and the number of arguments must match the number of placeholders.
+ */
+template <detail::fixed_string Format, typename... Ts>
+inline void fprint(FILE* file, const Ts&... args) {
+    detail::json_print_static<Format>(file, std::index_sequence_for<Ts...> {}, args...);
+}
+
+/**
+ * Writes null-terminated JSON text to a string buffer. The format string is validated 
+ * at compile-time, and the number of arguments must match the number of placeholders.
+ */
+template <detail::fixed_string Format, typename... Ts>
+inline void sprint(char* buffer, size_t size, const Ts&... args) {
+    if (size == 0)
+        return;
+    detail::string_buffer sbuffer = { buffer, buffer + size - 1 };
+    detail::json_print_static<Format>(&sbuffer, std::index_sequence_for<Ts...> {}, args...);
+    *sbuffer.begin = '\0';
+}
+
+}
+
+#endif
+
+namespace JsonPrint {
+namespace detail {
+
+template <typename T>
+struct non_deduced {
+    using type = T;
+};
+
+template <typename... Ts, typename Dest, size_t... Is>
+inline void json_print_indexed(Dest dest, const json_print_context& context, std::index_sequence<Is...>, const typename non_deduced<Ts>::type&... args) {
     // print the part of the format string before the first placeholder
     json_print_part(dest, context.parts[0], context.parts[1]);
 
@@ -697,20 +1515,57 @@ inline void json_print(Dest dest, const json_print_context& context, std::index_
     //   1) prints the argument JSON-formatted, and then 
     //   2) prints the part of the format string after the placeholder
     std::initializer_list<bool> _ { (
-        json_print_arg(dest, args),
-        json_print_part(dest, context.parts[Is+1] + 1, context.parts[Is+2]),
+        json_print_spec_arg(dest, context.specs[Is], args),
+        json_print_part(dest, part_begin(context, Is+1), context.parts[Is+2]),
         false
     )... };
 }
 
 template <typename Dest, typename... Ts>
 inline void json_print(Dest dest, const json_print_context& context, Ts&&... args) {
-    // forward template arguments with index
-    detail::json_print(dest, context, std::index_sequence_for<Ts...> {}, std::forward<Ts>(args)...);
+    // forward template arguments with index, as their decayed types so that e.g. int&, 
+    // const int& and int, or string literals of different lengths share one instantiation
+    detail::json_print_indexed<typename std::decay<Ts>::type...>(dest, context, std::index_sequence_for<Ts...> {}, args...);
+}
+
+/**
+ * Compiled format string bound to its arguments, printed in place of a placeholder.
+ * The context is copied, so the argument can outlive a temporary context.
+ */
+template <typename... Ts>
+struct json_template_arg {
+    json_print_context context;
+    std::tuple<Ts...> args;
+};
+
+template <typename Dest, size_t... Is, typename... Ts>
+inline void json_print_template_arg(Dest dest, const json_template_arg<Ts...>& n, std::index_sequence<Is...>) {
+    json_print(dest, n.context, std::get<Is>(n.args)...);
+}
+
+template <typename Dest, typename... Ts>
+inline void json_print_arg(Dest dest, const json_template_arg<Ts...>& n) {
+    json_print_template_arg(dest, n, std::index_sequence_for<Ts...> {});
 }
 
 }
 
+/**
+ * Binds a compiled format string to its arguments, so that it can be used
+ * as the argument for a placeholder of another format string. Lvalue arguments
+ * are referenced, rvalue arguments are moved into the result.
+ */
+template <typename... Ts>
+inline detail::json_template_arg<Ts...> json_template(const json_print_context& context, Ts&&... args) {
+    return { context, std::tuple<Ts...>(std::forward<Ts>(args)...) };
+}
+
+// Compact mode changes what the printing functions compile to, so they are declared in 
+// an inline namespace named after the mode, and each translation unit can pick its own.
+// The compact versions are declared by json_print_compact.hpp.
+#ifndef JP_COMPACT
+inline namespace inlined {
+
 template <typename... Ts>
 inline void json_print(const json_print_context& context, Ts&&... args) {
     // forward template arguments with index
@@ -725,14 +1580,35 @@ inline void json_fprint(FILE* file, const json_print_context& context, Ts&&... a
 
 template <typename... Ts>
 inline void json_sprint(char* buffer, size_t size, const json_print_context& context, Ts&&... args) {
-    // simulate stream with fat pointer
-    detail::string_buffer sbuffer = { buffer, buffer + size };
+    if (size == 0)
+        return;
+    // simulate stream with fat pointer, leaving room for the null terminator
+    detail::string_buffer sbuffer = { buffer, buffer + size - 1 };
     // forward template arguments with index
     detail::json_print(&sbuffer, context, std::forward<Ts>(args)...);
+    *sbuffer.begin = '\0';
 }
 
+}
+#endif
+
 }
 
-#define json_print_c(format, ...) ([&](){ constexpr auto x = JsonPrint::compile(format); JsonPrint::json_fprint(stdout, x, __VA_ARGS__); }())
-#define json_fprint_c(file, format, ...) ([&](){ constexpr auto x = JsonPrint::compile(format); JsonPrint::json_fprint(file, x, __VA_ARGS__); }())
-#define json_sprint_c(buffer, size, format, ...) ([&](){ constexpr auto x = JsonPrint::compile(format); JsonPrint::json_sprint(buffer, size, x, __VA_ARGS__); }())
+// rejects arguments that can't be spread into a "...?" placeholder of the format string
+#define JP_CHECK_SPREAD(x, args) static_assert(JsonPrint::detail::spreads_match<decltype(args)...>(x), "expected a map or a range of pairs with string keys for '...?'")
+
+#ifdef JP_STATS
+#define json_print_c(format, ...) ([&](auto&&... jp_args){ constexpr auto x = JsonPrint::compile(format); JP_CHECK_SPREAD(x, jp_args); static JsonPrint::json_print_site_stats site(__FILE__, __LINE__, format); JsonPrint::detail::json_print_measured(site, stdout, x, std::forward<decltype(jp_args)>(jp_args)...); }(__VA_ARGS__))
+#define json_fprint_c(file, format, ...) ([&](auto&&... jp_args){ constexpr auto x = JsonPrint::compile(format); JP_CHECK_SPREAD(x, jp_args); static JsonPrint::json_print_site_stats site(__FILE__, __LINE__, format); JsonPrint::detail::json_print_measured(site, file, x, std::forward<decltype(jp_args)>(jp_args)...); }(__VA_ARGS__))
+#define json_sprint_c(buffer, size, format, ...) ([&](auto&&... jp_args){ constexpr auto x = JsonPrint::compile(format); JP_CHECK_SPREAD(x, jp_args); static JsonPrint::json_print_site_stats site(__FILE__, __LINE__, format); JsonPrint::detail::json_sprint_measured(site, buffer, size, x, std::forward<decltype(jp_args)>(jp_args)...); }(__VA_ARGS__))
+#elif defined(JP_COMPACT)
+// the compact printer reads the context from memory, so it's stored once instead of built on each call
+#define json_print_c(format, ...) ([&](auto&&... jp_args){ static constexpr auto x = JsonPrint::compile(format); JP_CHECK_SPREAD(x, jp_args); JsonPrint::json_fprint(stdout, x, std::forward<decltype(jp_args)>(jp_args)...); }(__VA_ARGS__))
+#define json_fprint_c(file, format, ...) ([&](auto&&... jp_args){ static constexpr auto x = JsonPrint::compile(format); JP_CHECK_SPREAD(x, jp_args); JsonPrint::json_fprint(file, x, std::forward<decltype(jp_args)>(jp_args)...); }(__VA_ARGS__))
+#define json_sprint_c(buffer, size, format, ...) ([&](auto&&... jp_args){ static constexpr auto x = JsonPrint::compile(format); JP_CHECK_SPREAD(x, jp_args); JsonPrint::json_sprint(buffer, size, x, std::forward<decltype(jp_args)>(jp_args)...); }(__VA_ARGS__))
+#else
+#define json_print_c(format, ...) ([&](auto&&... jp_args){ constexpr auto x = JsonPrint::compile(format); JP_CHECK_SPREAD(x, jp_args); JsonPrint::json_fprint(stdout, x, std::forward<decltype(jp_args)>(jp_args)...); }(__VA_ARGS__))
+#define json_fprint_c(file, format, ...) ([&](auto&&... jp_args){ constexpr auto x = JsonPrint::compile(format); JP_CHECK_SPREAD(x, jp_args); JsonPrint::json_fprint(file, x, std::forward<decltype(jp_args)>(jp_args)...); }(__VA_ARGS__))
+#define json_sprint_c(buffer, size, format, ...) ([&](auto&&... jp_args){ constexpr auto x = JsonPrint::compile(format); JP_CHECK_SPREAD(x, jp_args); JsonPrint::json_sprint(buffer, size, x, std::forward<decltype(jp_args)>(jp_args)...); }(__VA_ARGS__))
+#endif
+#define json_template_c(format, ...) ([&](auto&&... jp_args){ static constexpr auto x = JsonPrint::compile(format); JP_CHECK_SPREAD(x, jp_args); return JsonPrint::json_template(x, std::forward<decltype(jp_args)>(jp_args)...); }(__VA_ARGS__))
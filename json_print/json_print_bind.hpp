@@ -0,0 +1,97 @@
+#include <initializer_list>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string.h>
+
+/*
+ * Optional partial application of templates. Include after json_print.hpp.
+ */
+
+namespace JsonPrint {
+
+/**
+ * Passed to json_bind in place of an argument, to leave its placeholder unbound
+ */
+struct json_unbound_t {};
+constexpr json_unbound_t json_unbound {};
+
+/**
+ * Format string with some of its placeholders replaced by pre-rendered values, owning
+ * its text. Can be passed anywhere a json_print_context is expected, with arguments
+ * for the remaining placeholders.
+ */
+class json_bound_template {
+public:
+    json_bound_template(const std::string& format) : size(format.size()), text(new char[format.size()]) {
+        memcpy(text.get(), format.data(), size);
+        context = compile(text.get(), text.get() + size);
+    }
+
+    operator const json_print_context&() const {
+        return context;
+    }
+
+    /** Text of the format string, with the bound values in place */
+    std::string str() const {
+        return std::string(text.get(), size);
+    }
+
+private:
+    size_t size;
+    // the text doesn't move with the object, so the context stays valid when moved
+    std::unique_ptr<char[]> text;
+    json_print_context context;
+};
+
+namespace detail {
+
+/** Renders one argument, or copies the placeholder and its specifier if it's left unbound */
+struct json_binder {
+    const json_print_context& context;
+    std::string& format;
+
+    template <typename T>
+    void bind(size_t index, const T& value) {
+        json_print_spec_arg(&format, context.specs[index], value);
+    }
+
+    void bind(size_t index, const json_unbound_t&) {
+        format.append(context.parts[index + 1], context.specs[index].length);
+    }
+
+    void literal(size_t index) {
+        json_print_part(&format, part_begin(context, index), context.parts[index + 1]);
+    }
+};
+
+}
+
+/**
+ * Renders the leading arguments of a format string once, and compiles the result into
+ * a new format string that takes only the remaining arguments. Pass json_unbound in
+ * place of an argument to leave its placeholder for later.
+ * @throws std::runtime_error if there are more arguments than placeholders
+ */
+template <typename... Ts>
+inline json_bound_template json_bind(const json_print_context& context, const Ts&... args) {
+    if (sizeof...(Ts) + 1 > context.count)
+        throw std::runtime_error("more arguments than placeholders");
+    std::string format;
+    detail::json_binder binder = { context, format };
+    size_t index = 0;
+    binder.literal(0);
+    std::initializer_list<bool> _ { (
+        binder.bind(index, args),
+        binder.literal(++index),
+        false
+    )... };
+    // placeholders after the bound arguments stay as they were
+    for (; index + 1 < context.count; index++) {
+        binder.bind(index, json_unbound);
+        binder.literal(index + 1);
+    }
+    return json_bound_template(format);
+}
+
+}
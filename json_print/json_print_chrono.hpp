@@ -0,0 +1,145 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string.h>
+
+/*
+ * Optional printing of std::chrono time points and durations. Include after
+ * json_print.hpp.
+ */
+
+namespace JsonPrint {
+namespace detail {
+
+/**
+ * Date and time of one second, formatted as "YYYY-MM-DDThh:mm:ss"
+ */
+struct iso8601_second {
+    long long second = 0;
+    bool valid = false;
+    char text[19];
+};
+
+inline void write_digits(char* text, unsigned value, int count) {
+    for (int i = count - 1; i >= 0; i--, value /= 10)
+        text[i] = static_cast<char>('0' + value % 10);
+}
+
+/** Formats seconds since the Unix epoch as UTC, without going through gmtime */
+inline void format_iso8601_second(iso8601_second& cache, long long second) {
+    long long days = second / 86400;
+    long long time = second % 86400;
+    if (time < 0) {
+        time += 86400;
+        days--;
+    }
+
+    // civil date from days since 1970-01-01, valid for the proleptic Gregorian calendar
+    days += 719468;
+    long long era = (days >= 0 ? days : days - 146096) / 146097;
+    unsigned day_of_era = static_cast<unsigned>(days - era * 146097);
+    unsigned year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    unsigned day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    unsigned shifted_month = (5 * day_of_year + 2) / 153;
+    unsigned day = day_of_year - (153 * shifted_month + 2) / 5 + 1;
+    unsigned month = shifted_month < 10 ? shifted_month + 3 : shifted_month - 9;
+    long long year = static_cast<long long>(year_of_era) + era * 400 + (month <= 2);
+    if (year < 0 || year > 9999)
+        throw std::runtime_error("expected a time point between the years 0000 and 9999");
+
+    char* text = cache.text;
+    write_digits(text, static_cast<unsigned>(year), 4);
+    text[4] = '-';
+    write_digits(text + 5, month, 2);
+    text[7] = '-';
+    write_digits(text + 8, day, 2);
+    text[10] = 'T';
+    write_digits(text + 11, static_cast<unsigned>(time / 3600), 2);
+    text[13] = ':';
+    write_digits(text + 14, static_cast<unsigned>(time / 60 % 60), 2);
+    text[16] = ':';
+    write_digits(text + 17, static_cast<unsigned>(time % 60), 2);
+    cache.second = second;
+    cache.valid = true;
+}
+
+/**
+ * Prints milliseconds since the Unix epoch as an ISO-8601 string. The date and time
+ * of the last second printed is cached per thread, so usually only the milliseconds
+ * are formatted.
+ */
+template <typename Dest>
+inline void json_print_iso8601(Dest dest, long long milliseconds) {
+    static thread_local iso8601_second cache;
+    long long second = milliseconds / 1000;
+    long long fraction = milliseconds % 1000;
+    if (fraction < 0) {
+        fraction += 1000;
+        second--;
+    }
+    if (!cache.valid || cache.second != second)
+        format_iso8601_second(cache, second);
+
+    // "YYYY-MM-DDThh:mm:ss.sssZ" with quotes
+    char text[26];
+    text[0] = '"';
+    memcpy(text + 1, cache.text, sizeof(cache.text));
+    text[20] = '.';
+    write_digits(text + 21, static_cast<unsigned>(fraction), 3);
+    text[24] = 'Z';
+    text[25] = '"';
+    write_string(dest, text, text + sizeof(text));
+}
+
+template <typename Duration>
+inline long long to_milliseconds(Duration duration) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+}
+
+/**
+ * Prints a duration as an ISO-8601 duration string of seconds, e.g. "PT1.500S"
+ */
+template <typename Dest>
+inline void json_print_iso8601_duration(Dest dest, long long milliseconds) {
+    const char* sign = milliseconds < 0 ? "-" : "";
+    unsigned long long magnitude = milliseconds < 0 ? 0ULL - static_cast<unsigned long long>(milliseconds) : milliseconds;
+    write_printf(dest, "\"%sPT%llu.%03lluS\"", sign, magnitude / 1000, magnitude % 1000);
+}
+
+template <typename Dest, typename Duration>
+inline void json_print_arg(Dest dest, const std::chrono::time_point<std::chrono::system_clock, Duration>& n) {
+    json_print_iso8601(dest, to_milliseconds(n.time_since_epoch()));
+}
+
+template <typename Dest, typename Rep, typename Period>
+inline void json_print_arg(Dest dest, const std::chrono::duration<Rep, Period>& n) {
+    json_print_iso8601_duration(dest, to_milliseconds(n));
+}
+
+}
+
+/*
+ * With ?{ms}, printed as a number of milliseconds instead. These are declared next to
+ * json_print_spec rather than in detail, so that the printing functions and the
+ * elements of containers, which are defined before this header, find them through
+ * the specifier for any sink.
+ */
+
+template <typename Dest, typename Duration>
+inline void json_print_spec_arg(Dest dest, const json_print_spec& spec, const std::chrono::time_point<std::chrono::system_clock, Duration>& n) {
+    if (spec.type == 'm')
+        detail::json_print_arg(dest, detail::to_milliseconds(n.time_since_epoch()));
+    else
+        detail::json_print_arg(dest, n);
+}
+
+template <typename Dest, typename Rep, typename Period>
+inline void json_print_spec_arg(Dest dest, const json_print_spec& spec, const std::chrono::duration<Rep, Period>& n) {
+    if (spec.type == 'm')
+        detail::json_print_arg(dest, detail::to_milliseconds(n));
+    else
+        detail::json_print_arg(dest, n);
+}
+
+}
@@ -0,0 +1,270 @@
+#include <cstdio>
+#include <string.h>
+#include <string>
+#include <utility>
+
+#if defined(_MSC_VER)
+#define JP_NOINLINE __declspec(noinline)
+#else
+#define JP_NOINLINE __attribute__((noinline))
+#endif
+
+/*
+ * Optional compact mode, which trades speed for code size when JP_COMPACT is defined.
+ * Include after json_print.hpp.
+ */
+
+namespace JsonPrint {
+namespace detail {
+
+/**
+ * Type-erased sink, so that the compact printer is compiled once for all destinations.
+ * Text is collected in a small buffer, so that most writes don't go through the
+ * function pointer.
+ */
+struct compact_sink {
+    void* dest;
+    void (*write)(void* dest, const char* begin, const char* end);
+    char* end;
+    char buffer[256];
+
+    void flush() {
+        write(dest, buffer, end);
+        end = buffer;
+    }
+};
+
+template <typename Dest>
+inline void compact_write(void* dest, const char* begin, const char* end) {
+    write_string(static_cast<Dest>(dest), begin, end);
+}
+
+inline void write_char(compact_sink* sink, const char c) {
+    if (sink->end == sink->buffer + sizeof(sink->buffer))
+        sink->flush();
+    *sink->end++ = c;
+}
+
+inline int write_string(compact_sink* sink, const char* begin, const char* end) {
+    size_t size = end - begin;
+    if (size > static_cast<size_t>(sink->buffer + sizeof(sink->buffer) - sink->end)) {
+        sink->flush();
+        if (size > sizeof(sink->buffer)) {
+            sink->write(sink->dest, begin, end);
+            return static_cast<int>(size);
+        }
+    }
+    memcpy(sink->end, begin, size);
+    sink->end += size;
+    return static_cast<int>(size);
+}
+
+inline int write_string_unsafe(compact_sink* sink, const char* text) {
+    return write_string(sink, text, text + strlen(text));
+}
+
+template <typename... T>
+int write_printf(compact_sink* sink, const char* format, T&&... args) {
+    return format_printf([sink](const char* text, const char* text_end) { write_string(sink, text, text_end); }, format, args...);
+}
+
+enum compact_tag : unsigned char {
+    compact_null,
+    compact_bool,
+    compact_signed,
+    compact_unsigned,
+    compact_double,
+    compact_string,
+    compact_other
+};
+
+/**
+ * Argument laid out by a call site for the compact printer. Numbers and strings are
+ * stored by value, anything else is printed through a function pointer.
+ */
+struct compact_arg {
+    compact_tag tag = compact_null;
+
+    /** Size of the original integer type, for hexadecimal output */
+    unsigned char size = 0;
+
+    union {
+        bool b;
+        long long i;
+        unsigned long long u = 0;
+        double d;
+        struct {
+            const char* begin;
+            size_t size;
+        } s;
+        struct {
+            const void* value;
+            void (*print)(compact_sink* sink, const json_print_spec& spec, const void* value);
+        } other;
+    };
+
+    compact_arg() = default;
+    compact_arg(compact_tag tag, unsigned char size) : tag(tag), size(size) {}
+};
+
+template <typename T>
+inline void compact_print_other(compact_sink* sink, const json_print_spec& spec, const void* value) {
+    json_print_spec_arg(sink, spec, *static_cast<const T*>(value));
+}
+
+template <typename T>
+inline compact_arg make_compact_arg(const T& n) {
+    compact_arg arg = { compact_other, 0 };
+    arg.other.value = &n;
+    arg.other.print = &compact_print_other<T>;
+    return arg;
+}
+
+inline compact_arg make_compact_arg(std::nullptr_t) {
+    return { compact_null, 0 };
+}
+
+inline compact_arg make_compact_arg(bool n) {
+    compact_arg arg = { compact_bool, 0 };
+    arg.b = n;
+    return arg;
+}
+
+inline compact_arg make_compact_signed(long long n, unsigned char size) {
+    compact_arg arg = { compact_signed, size };
+    arg.i = n;
+    return arg;
+}
+
+inline compact_arg make_compact_unsigned(unsigned long long n, unsigned char size) {
+    compact_arg arg = { compact_unsigned, size };
+    arg.u = n;
+    return arg;
+}
+
+inline compact_arg make_compact_arg(short n) { return make_compact_signed(n, sizeof(n)); }
+inline compact_arg make_compact_arg(int n) { return make_compact_signed(n, sizeof(n)); }
+inline compact_arg make_compact_arg(long n) { return make_compact_signed(n, sizeof(n)); }
+inline compact_arg make_compact_arg(long long n) { return make_compact_signed(n, sizeof(n)); }
+inline compact_arg make_compact_arg(unsigned char n) { return make_compact_unsigned(n, sizeof(n)); }
+inline compact_arg make_compact_arg(unsigned short n) { return make_compact_unsigned(n, sizeof(n)); }
+inline compact_arg make_compact_arg(unsigned n) { return make_compact_unsigned(n, sizeof(n)); }
+inline compact_arg make_compact_arg(unsigned long n) { return make_compact_unsigned(n, sizeof(n)); }
+inline compact_arg make_compact_arg(unsigned long long n) { return make_compact_unsigned(n, sizeof(n)); }
+
+inline compact_arg make_compact_arg(double n) {
+    compact_arg arg = { compact_double, 0 };
+    arg.d = n;
+    return arg;
+}
+
+inline compact_arg make_compact_arg(float n) { return make_compact_arg(static_cast<double>(n)); }
+inline compact_arg make_compact_arg(long double n) { return make_compact_arg(static_cast<double>(n)); }
+
+inline compact_arg make_compact_string(const char* begin, size_t size) {
+    compact_arg arg = { compact_string, 0 };
+    arg.s.begin = begin;
+    arg.s.size = size;
+    return arg;
+}
+
+inline compact_arg make_compact_arg(const char& n) { return make_compact_string(&n, 1); }
+inline compact_arg make_compact_arg(const char* n) { return make_compact_string(n, strlen(n)); }
+inline compact_arg make_compact_arg(const std::string& n) { return make_compact_string(n.data(), n.size()); }
+
+#ifdef __cpp_lib_string_view
+inline compact_arg make_compact_arg(std::string_view n) { return make_compact_string(n.data(), n.size()); }
+#endif
+
+inline void json_print_compact_arg(compact_sink* sink, const json_print_spec& spec, const compact_arg& arg) {
+    switch (arg.tag) {
+        case compact_null:
+            json_print_arg(sink, nullptr);
+            break;
+
+        case compact_bool:
+            json_print_arg(sink, arg.b);
+            break;
+
+        case compact_signed:
+            if ((spec.type == 'x' || spec.type == 'X') && arg.size < sizeof(arg.u)) {
+                // hexadecimal of the original type's two's complement
+                json_print_spec_arg(sink, spec, arg.u & ((1ULL << (arg.size * 8)) - 1));
+                break;
+            }
+            json_print_spec_arg(sink, spec, arg.i);
+            break;
+
+        case compact_unsigned:
+            json_print_spec_arg(sink, spec, arg.u);
+            break;
+
+        case compact_double:
+            json_print_spec_arg(sink, spec, arg.d);
+            break;
+
+        case compact_string:
+            json_print_string(sink, arg.s.begin, arg.s.begin + arg.s.size);
+            break;
+
+        case compact_other:
+            arg.other.print(sink, spec, arg.other.value);
+            break;
+    }
+}
+
+/**
+ * Prints the literal parts and laid out arguments of every call site in compact mode
+ */
+JP_NOINLINE inline void json_print_compact_args(void* dest, void (*write)(void*, const char*, const char*), 
+        const json_print_context& context, const compact_arg* args, size_t count) {
+    compact_sink sink = {};
+    sink.dest = dest;
+    sink.write = write;
+    sink.end = sink.buffer;
+    json_print_part(&sink, context.parts[0], context.parts[1]);
+    for (size_t i = 0; i < count; i++) {
+        json_print_compact_arg(&sink, context.specs[i], args[i]);
+        json_print_part(&sink, part_begin(context, i + 1), context.parts[i + 2]);
+    }
+    sink.flush();
+}
+
+/**
+ * Lays out the arguments into a tagged array and hands them to the out-of-line printer
+ */
+template <typename Dest, typename... Ts>
+inline void json_print_compact(Dest dest, const json_print_context& context, const Ts&... args) {
+    const compact_arg compact_args[sizeof...(Ts) + 1] = { make_compact_arg(args)... };
+    json_print_compact_args(dest, &compact_write<Dest>, context, compact_args, sizeof...(Ts));
+}
+
+}
+
+#ifdef JP_COMPACT
+inline namespace compact {
+
+template <typename... Ts>
+inline void json_print(const json_print_context& context, Ts&&... args) {
+    detail::json_print_compact(stdout, context, args...);
+}
+
+template <typename... Ts>
+inline void json_fprint(FILE* file, const json_print_context& context, Ts&&... args) {
+    detail::json_print_compact(file, context, args...);
+}
+
+template <typename... Ts>
+inline void json_sprint(char* buffer, size_t size, const json_print_context& context, Ts&&... args) {
+    if (size == 0)
+        return;
+    // simulate stream with fat pointer, leaving room for the null terminator
+    detail::string_buffer sbuffer = { buffer, buffer + size - 1 };
+    detail::json_print_compact(&sbuffer, context, args...);
+    *sbuffer.begin = '\0';
+}
+
+}
+#endif
+
+}
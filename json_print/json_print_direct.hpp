@@ -0,0 +1,282 @@
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <errno.h>
+#include <fcntl.h>
+#include <mutex>
+#include <stdexcept>
+#include <string.h>
+#include <thread>
+#include <unistd.h>
+
+/*
+ * Optional file sink that writes with O_DIRECT, bypassing the page cache, while
+ * the next block is formatted. Include after json_print.hpp. Linux only.
+ */
+
+namespace JsonPrint {
+
+/**
+ * Settings for a direct file writer
+ */
+struct json_direct_options {
+    /** Size of each of the two buffers, rounded up to a multiple of the block alignment */
+    size_t buffer_size = 1024 * 1024;
+
+    /** Alignment of buffers, file offsets and sizes required by O_DIRECT, in bytes */
+    size_t alignment = 4096;
+
+    /**
+     * If the file system doesn't support O_DIRECT, write through the page cache and
+     * drop the written pages from it, instead of throwing
+     */
+    bool fallback = true;
+};
+
+namespace detail {
+
+/**
+ * Sink that formats into one aligned buffer while a background thread writes the
+ * other one to the file. The unaligned tail is padded to a whole block when the
+ * writer is closed, and the file is truncated back to the length printed.
+ */
+class direct_writer {
+public:
+    direct_writer(const char* path, json_direct_options options = {}) : options(options) {
+        if (options.alignment == 0 || (options.alignment & (options.alignment - 1)) != 0)
+            throw std::runtime_error("direct writer alignment must be a power of two");
+        size = (std::max)(options.buffer_size, options.alignment);
+        size = (size + options.alignment - 1) / options.alignment * options.alignment;
+
+        fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+        if (fd < 0 && errno == EINVAL && options.fallback) {
+            fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            direct = false;
+        }
+        if (fd < 0)
+            throw std::runtime_error("failed to open file for direct writes");
+
+        for (char*& buffer : buffers) {
+            void* memory = nullptr;
+            if (posix_memalign(&memory, options.alignment, size) != 0) {
+                release();
+                throw std::bad_alloc();
+            }
+            buffer = static_cast<char*>(memory);
+        }
+        begin = buffers[0];
+        end = begin;
+        limit = begin + size;
+        thread = std::thread([this]() { write_blocks(); });
+    }
+
+    direct_writer(const direct_writer&) = delete;
+    direct_writer& operator=(const direct_writer&) = delete;
+
+    ~direct_writer() {
+        try {
+            close();
+        } catch (...) {
+            stop();
+            release();
+        }
+    }
+
+    /**
+     * Writes the remaining text, waits for the background writes to finish and closes
+     * the file
+     */
+    void close() {
+        if (fd < 0)
+            return;
+        unsigned long long length = offset + (end - begin);
+        size_t tail = end - begin;
+        if (tail != 0) {
+            // O_DIRECT only writes whole blocks, so the tail is padded and cut off afterwards
+            size_t padded = (tail + options.alignment - 1) / options.alignment * options.alignment;
+            memset(end, 0, padded - tail);
+            end = begin + padded;
+            hand_off();
+        }
+        stop();
+        if (error == 0 && tail != 0 && ftruncate(fd, static_cast<off_t>(length)) != 0)
+            error = errno;
+        release();
+        if (error != 0)
+            throw std::runtime_error("failed to write file");
+    }
+
+    /** Whether the file was opened with O_DIRECT, or fell back to the page cache */
+    bool is_direct() const {
+        return direct;
+    }
+
+    void write(const char* begin, const char* end) {
+        while (begin != end) {
+            if (this->end == limit)
+                submit();
+            size_t count = (std::min)(static_cast<size_t>(end - begin), static_cast<size_t>(limit - this->end));
+            memcpy(this->end, begin, count);
+            this->end += count;
+            begin += count;
+        }
+    }
+
+    void write(char c) {
+        if (end == limit)
+            submit();
+        *end++ = c;
+    }
+
+    template <typename... T>
+    int write_printf(const char* format, T&&... args) {
+        return format_printf([this](const char* text, const char* text_end) { write(text, text_end); }, format, args...);
+    }
+
+private:
+    void submit() {
+        if (hand_off() != 0)
+            throw std::runtime_error("failed to write file");
+    }
+
+    /**
+     * Hands the filled buffer to the background thread, and continues in the other one.
+     * Returns the error of an earlier write, if any.
+     */
+    int hand_off() {
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [this]() { return pending == nullptr; });
+        int result = error;
+        pending = begin;
+        pending_size = end - begin;
+        pending_offset = offset;
+        offset += pending_size;
+        ready.notify_one();
+        lock.unlock();
+
+        begin = begin == buffers[0] ? buffers[1] : buffers[0];
+        end = begin;
+        limit = begin + size;
+        return result;
+    }
+
+    void write_blocks() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            ready.wait(lock, [this]() { return pending != nullptr || stopping; });
+            if (pending == nullptr)
+                return;
+            const char* data = pending;
+            size_t remaining = pending_size;
+            unsigned long long position = pending_offset;
+            lock.unlock();
+
+            int result = 0;
+            while (remaining != 0) {
+                ssize_t written = pwrite(fd, data, remaining, static_cast<off_t>(position));
+                if (written < 0 && errno == EINTR)
+                    continue;
+                if (written <= 0) {
+                    result = written < 0 ? errno : EIO;
+                    break;
+                }
+                data += written;
+                remaining -= written;
+                position += written;
+            }
+            if (!direct && result == 0) {
+                // keep the written pages out of the page cache
+                fdatasync(fd);
+                posix_fadvise(fd, static_cast<off_t>(pending_offset), static_cast<off_t>(pending_size), POSIX_FADV_DONTNEED);
+            }
+
+            lock.lock();
+            if (result != 0)
+                error = result;
+            pending = nullptr;
+            idle.notify_one();
+        }
+    }
+
+    void stop() {
+        if (!thread.joinable())
+            return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            ready.notify_one();
+        }
+        thread.join();
+    }
+
+    void release() {
+        if (fd >= 0)
+            ::close(fd);
+        fd = -1;
+        for (char*& buffer : buffers) {
+            free(buffer);
+            buffer = nullptr;
+        }
+    }
+
+    json_direct_options options;
+    int fd = -1;
+    bool direct = true;
+    size_t size = 0;
+    char* buffers[2] = { nullptr, nullptr };
+    char* begin = nullptr;
+    char* end = nullptr;
+    char* limit = nullptr;
+    unsigned long long offset = 0;
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::condition_variable idle;
+    const char* pending = nullptr;
+    size_t pending_size = 0;
+    unsigned long long pending_offset = 0;
+    bool stopping = false;
+    int error = 0;
+};
+
+inline void write_char(direct_writer* writer, const char c) {
+    writer->write(c);
+}
+
+inline int write_string(direct_writer* writer, const char* begin, const char* end) {
+    writer->write(begin, end);
+    return static_cast<int>(end - begin);
+}
+
+inline int write_string_unsafe(direct_writer* writer, const char* text) {
+    return write_string(writer, text, text + strlen(text));
+}
+
+template <typename... T>
+int write_printf(direct_writer* writer, const char* format, T&&... args) {
+    return writer->write_printf(format, std::forward<T>(args)...);
+}
+
+}
+
+/**
+ * Writer that prints JSON text to a file with O_DIRECT, so that large dumps don't
+ * fill the page cache. Formatting continues in one buffer while the other is
+ * written by a background thread. The file is complete once the writer is closed
+ * or destroyed.
+ */
+using json_direct_writer = detail::direct_writer;
+
+/**
+ * Prints one record of JSON text into a direct file writer
+ */
+template <typename... Ts>
+inline void json_direct_print(json_direct_writer& writer, const json_print_context& context, Ts&&... args) {
+    detail::json_print(&writer, context, std::forward<Ts>(args)...);
+}
+
+}
+
+#define json_direct_print_c(writer, format, ...) ([&](auto&&... jp_args){ constexpr auto x = JsonPrint::compile(format); JP_CHECK_SPREAD(x, jp_args); JsonPrint::json_direct_print(writer, x, std::forward<decltype(jp_args)>(jp_args)...); }(__VA_ARGS__))
@@ -0,0 +1,92 @@
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <string.h>
+#include <utility>
+#include <vector>
+
+/*
+ * Optional pre-rendered documents, updated in place. Include after json_print.hpp.
+ */
+
+namespace JsonPrint {
+
+/**
+ * JSON text rendered once from a compiled format string, with each placeholder in a
+ * fixed-width slot padded with spaces. A placeholder is updated by overwriting its
+ * slot in place, so the rest of the document is never printed again.
+ * Updates aren't synchronized with readers of the text.
+ */
+class json_document {
+public:
+    /**
+     * Renders a format string with its arguments, giving every placeholder a slot of
+     * width bytes
+     * @throws std::runtime_error if the number of arguments doesn't match the placeholders
+     * @throws std::length_error if an argument doesn't fit in its slot
+     */
+    template <typename... Ts>
+    json_document(const json_print_context& context, size_t width, const Ts&... args)
+        : context(context), width(width) {
+        static_assert(sizeof...(Ts) <= JP_MAX_PLACEHOLDERS, "too many arguments");
+        if (sizeof...(Ts) + 1 != context.count)
+            throw std::runtime_error("number of arguments doesn't match the placeholders");
+        detail::json_print_part(&text, context.parts[0], context.parts[1]);
+        size_t index = 0;
+        std::initializer_list<bool> _ { (
+            slots.push_back(text.size()),
+            text.append(width, ' '),
+            set(index, args),
+            detail::json_print_part(&text, detail::part_begin(context, index + 1), context.parts[index + 2]),
+            index++,
+            false
+        )... };
+    }
+
+    /**
+     * Prints a new value into the slot of a placeholder, and pads the rest of the slot
+     * @throws std::out_of_range if there's no such placeholder
+     * @throws std::length_error if the value doesn't fit in the slot, leaving the slot unchanged
+     */
+    template <typename T>
+    void set(size_t index, const T& value) {
+        if (index >= slots.size())
+            throw std::out_of_range("no such placeholder");
+        scratch.clear();
+        // unqualified, so that the overloads of the optional headers are found too
+        using detail::json_print_spec_arg;
+        json_print_spec_arg(&scratch, context.specs[index], value);
+        if (scratch.size() > width)
+            throw std::length_error("value doesn't fit in its slot");
+        char* slot = &text[slots[index]];
+        memcpy(slot, scratch.data(), scratch.size());
+        memset(slot + scratch.size(), ' ', width - scratch.size());
+    }
+
+    /** The rendered JSON text */
+    const std::string& str() const {
+        return text;
+    }
+
+    const char* data() const {
+        return text.data();
+    }
+
+    size_t size() const {
+        return text.size();
+    }
+
+    /** Offset of a placeholder's slot in the text */
+    size_t slot(size_t index) const {
+        return slots.at(index);
+    }
+
+private:
+    json_print_context context;
+    size_t width;
+    std::string text;
+    std::vector<size_t> slots;
+    std::string scratch;
+};
+
+}
@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <cstdio>
+#include <errno.h>
+#include <poll.h>
+#include <stdexcept>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <vector>
+
+/*
+ * Optional sink that writes to a file descriptor through its own buffer, bypassing
+ * stdio. Include after json_print.hpp. POSIX only.
+ */
+
+namespace JsonPrint {
+
+/**
+ * When a file descriptor writer writes its buffer
+ */
+enum json_fd_flush {
+    /** Only when the buffer fills up, on flush() and when destroyed */
+    json_fd_flush_buffer,
+    /** After every record */
+    json_fd_flush_record
+};
+
+/**
+ * Buffering settings for a file descriptor writer
+ */
+struct json_fd_options {
+    /** Size of the buffer, in bytes */
+    size_t buffer_size = 64 * 1024;
+
+    /** When the buffer is written */
+    json_fd_flush flush = json_fd_flush_buffer;
+};
+
+namespace detail {
+
+/**
+ * Sink that collects text in a buffer and writes it to a file descriptor with write,
+ * or writev when a long string doesn't fit. Interrupted and partial writes are
+ * retried, and non-blocking descriptors are polled until they're writable.
+ */
+class fd_writer {
+public:
+    fd_writer(int fd, json_fd_options options = {}) 
+        : fd(fd), options(options), buffer((std::max)(options.buffer_size, size_t(128))), end(buffer.data()) {}
+
+    fd_writer(const fd_writer&) = delete;
+    fd_writer& operator=(const fd_writer&) = delete;
+
+    ~fd_writer() {
+        try {
+            flush();
+        } catch (...) {
+        }
+    }
+
+    /**
+     * Writes everything buffered so far. Doesn't sync the file.
+     */
+    void flush() {
+        write_all(buffer.data(), end - buffer.data(), nullptr, 0);
+        end = buffer.data();
+    }
+
+    /** Called after each record is printed */
+    void end_record() {
+        if (options.flush == json_fd_flush_record)
+            flush();
+    }
+
+    /** Bytes written to the file descriptor so far, not counting the buffer */
+    unsigned long long written() const {
+        return total;
+    }
+
+    void write(const char* begin, const char* end) {
+        size_t size = end - begin;
+        if (size > static_cast<size_t>(buffer.data() + buffer.size() - this->end)) {
+            if (size >= buffer.size()) {
+                // write the buffer and the string together, without copying the string
+                write_all(buffer.data(), this->end - buffer.data(), begin, size);
+                this->end = buffer.data();
+                return;
+            }
+            flush();
+        }
+        memcpy(this->end, begin, size);
+        this->end += size;
+    }
+
+    void write(char c) {
+        if (end == buffer.data() + buffer.size())
+            flush();
+        *end++ = c;
+    }
+
+    template <typename... T>
+    int write_printf(const char* format, T&&... args) {
+        // numbers are printed straight into the buffer
+        if (buffer.data() + buffer.size() - end < printf_buffer_size)
+            flush();
+        int result = snprintf(end, printf_buffer_size, format, args...);
+        if (result >= 0 && result < printf_buffer_size) {
+            end += result;
+            return result;
+        }
+        // longer text, like "%.99f" of a large number, is formatted on the side
+        return format_printf([this](const char* text, const char* text_end) { write(text, text_end); }, format, args...);
+    }
+
+private:
+    void write_all(const char* first, size_t first_size, const char* second, size_t second_size) {
+        struct iovec parts[2] = { { const_cast<char*>(first), first_size }, { const_cast<char*>(second), second_size } };
+        struct iovec* part = first_size != 0 ? parts : parts + 1;
+        int count = static_cast<int>(parts + (second_size != 0 ? 2 : 1) - part);
+        while (count > 0) {
+            ssize_t result = count == 1 ? ::write(fd, part->iov_base, part->iov_len) : ::writev(fd, part, count);
+            if (result < 0) {
+                if (errno == EINTR)
+                    continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    struct pollfd writable = { fd, POLLOUT, 0 };
+                    poll(&writable, 1, -1);
+                    continue;
+                }
+                throw std::runtime_error("failed to write to file descriptor");
+            }
+            total += result;
+            // skip what was written, which may end in the middle of a part
+            size_t written = static_cast<size_t>(result);
+            while (count > 0 && written >= part->iov_len) {
+                written -= part->iov_len;
+                part++;
+                count--;
+            }
+            if (count > 0) {
+                part->iov_base = static_cast<char*>(part->iov_base) + written;
+                part->iov_len -= written;
+            }
+        }
+    }
+
+    int fd;
+    json_fd_options options;
+    std::vector<char> buffer;
+    char* end;
+    unsigned long long total = 0;
+};
+
+inline void write_char(fd_writer* writer, const char c) {
+    writer->write(c);
+}
+
+inline int write_string(fd_writer* writer, const char* begin, const char* end) {
+    writer->write(begin, end);
+    return static_cast<int>(end - begin);
+}
+
+inline int write_string_unsafe(fd_writer* writer, const char* text) {
+    return write_string(writer, text, text + strlen(text));
+}
+
+template <typename... T>
+int write_printf(fd_writer* writer, const char* format, T&&... args) {
+    return writer->write_printf(format, std::forward<T>(args)...);
+}
+
+}
+
+/**
+ * Writer that buffers JSON text and writes it to a file descriptor, without going
+ * through stdio. The buffer is written when the writer is destroyed, but the file
+ * descriptor isn't closed.
+ */
+using json_fd_writer = detail::fd_writer;
+
+/**
+ * Prints one record of JSON text into a file descriptor writer
+ */
+template <typename... Ts>
+inline void json_fdprint(json_fd_writer& writer, const json_print_context& context, Ts&&... args) {
+    detail::json_print(&writer, context, std::forward<Ts>(args)...);
+    writer.end_record();
+}
+
+}
+
+#define json_fdprint_c(writer, format, ...) ([&](auto&&... jp_args){ constexpr auto x = JsonPrint::compile(format); JP_CHECK_SPREAD(x, jp_args); JsonPrint::json_fdprint(writer, x, std::forward<decltype(jp_args)>(jp_args)...); }(__VA_ARGS__))
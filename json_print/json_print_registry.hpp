@@ -0,0 +1,158 @@
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <string.h>
+#include <unordered_map>
+
+/*
+ * Optional registry of templates compiled at run-time. Include after json_print.hpp.
+ */
+
+namespace JsonPrint {
+
+/**
+ * Format string owned and compiled by a registry. Can be passed anywhere a
+ * json_print_context is expected.
+ */
+struct json_registered_template {
+    /** Index of the template in its registry, in order of registration */
+    size_t id;
+
+    /** Name of the template, owned by the registry */
+    const char* name;
+
+    /** The compiled format string, pointing into text owned by the registry */
+    json_print_context context;
+
+    operator const json_print_context&() const {
+        return context;
+    }
+};
+
+/**
+ * Compiles format strings known only at run-time (e.g. from configuration) once,
+ * keeping a copy of their text for as long as the registry lives. Templates are 
+ * found by name or id in constant time. Lookups can run concurrently with each 
+ * other and with registration, and the templates they return never move.
+ */
+class json_template_registry {
+public:
+    json_template_registry() = default;
+    json_template_registry(const json_template_registry&) = delete;
+    json_template_registry& operator=(const json_template_registry&) = delete;
+
+    /**
+     * Copies and compiles a format string, and registers it under a name
+     * @throws std::runtime_error if the format string is invalid, or the name is already registered
+     */
+    const json_registered_template& add(const std::string& name, const char* begin, const char* end) {
+        std::unique_lock<std::shared_timed_mutex> lock(mutex);
+        if (names.find({ name.data(), name.size() }) != names.end())
+            throw std::runtime_error("template name already registered");
+
+        // compile before allocating anything, so invalid templates leave no trace,
+        // then point the parts at the copy. The name is kept in the same storage.
+        json_print_context context = compile(begin, end);
+        size_t size = end - begin;
+        char* text = allocate(size);
+        memcpy(text, begin, size);
+        for (size_t i = 0; i <= context.count; i++)
+            context.parts[i] = text + (context.parts[i] - begin);
+
+        char* name_text = allocate(name.size() + 1);
+        memcpy(name_text, name.c_str(), name.size() + 1);
+        names.emplace(name_key { name_text, name.size() }, templates.size());
+        templates.push_back({ templates.size(), name_text, context });
+        return templates.back();
+    }
+
+    /**
+     * Copies and compiles a format string, and registers it under a name
+     * @throws std::runtime_error if the format string is invalid, or the name is already registered
+     */
+    const json_registered_template& add(const std::string& name, const std::string& format) {
+        return add(name, format.data(), format.data() + format.size());
+    }
+
+    /** Finds a template by name, or returns null */
+    const json_registered_template* find(const std::string& name) const {
+        return find_name(name.data(), name.size());
+    }
+
+    /** Finds a template by name, or returns null, without copying the name into a string */
+    const json_registered_template* find(const char* name) const {
+        return find_name(name, strlen(name));
+    }
+
+#ifdef __cpp_lib_string_view
+    const json_registered_template* find(std::string_view name) const {
+        return find_name(name.data(), name.size());
+    }
+#endif
+
+    /** Finds a template by id, or returns null */
+    const json_registered_template* find(size_t id) const {
+        std::shared_lock<std::shared_timed_mutex> lock(mutex);
+        return id < templates.size() ? &templates[id] : nullptr;
+    }
+
+    /** Number of registered templates */
+    size_t size() const {
+        std::shared_lock<std::shared_timed_mutex> lock(mutex);
+        return templates.size();
+    }
+
+private:
+    static constexpr size_t block_size = 4096;
+
+    /** Name of a template, pointing into text owned by the registry, or by the caller for lookups */
+    struct name_key {
+        const char* data;
+        size_t size;
+
+        bool operator==(const name_key& other) const {
+            return size == other.size && memcmp(data, other.data, size) == 0;
+        }
+    };
+
+    /** FNV-1a hash of a name */
+    struct name_hash {
+        size_t operator()(const name_key& key) const {
+            unsigned long long hash = 14695981039346656037ULL;
+            for (size_t i = 0; i < key.size; i++)
+                hash = (hash ^ static_cast<unsigned char>(key.data[i])) * 1099511628211ULL;
+            return static_cast<size_t>(hash);
+        }
+    };
+
+    const json_registered_template* find_name(const char* name, size_t size) const {
+        std::shared_lock<std::shared_timed_mutex> lock(mutex);
+        auto it = names.find({ name, size });
+        return it == names.end() ? nullptr : &templates[it->second];
+    }
+
+    /** Allocates text storage from the current block, starting a new one when it's full */
+    char* allocate(size_t size) {
+        if (blocks.empty() || block_used + size > block_capacity) {
+            block_capacity = (std::max)(size, block_size);
+            blocks.emplace_back(new char[block_capacity]);
+            block_used = 0;
+        }
+        char* text = blocks.back().get() + block_used;
+        block_used += size;
+        return text;
+    }
+
+    mutable std::shared_timed_mutex mutex;
+    std::deque<json_registered_template> templates;
+    std::unordered_map<name_key, size_t, name_hash> names;
+    std::deque<std::unique_ptr<char[]>> blocks;
+    size_t block_used = 0;
+    size_t block_capacity = 0;
+};
+
+}
@@ -0,0 +1,436 @@
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <string.h>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/*
+ * Optional printing into a series of fixed-size buffers. Include after json_print.hpp.
+ */
+
+#ifndef JP_MAX_RESUMABLE_TAIL
+#define JP_MAX_RESUMABLE_TAIL (1 << 20)
+#endif
+
+namespace JsonPrint {
+
+/**
+ * Result of writing part of a resumable print into a buffer
+ */
+enum json_print_status {
+    /** All of the text has been written */
+    json_print_done,
+    /** The buffer is full, and more text is pending */
+    json_print_pending
+};
+
+namespace detail {
+
+/**
+ * Buffer that a resumable print writes into. Text that doesn't fit is kept in
+ * the tail, and written at the start of the next buffer.
+ */
+struct resumable_buffer {
+    char* begin;
+    char* end;
+    std::string* tail;
+    size_t max_tail;
+
+    bool full() const {
+        return begin == end;
+    }
+
+    size_t space() const {
+        return end - begin;
+    }
+};
+
+inline int write_string(resumable_buffer* buffer, const char* begin, const char* end) {
+    size_t size = end - begin;
+    size_t copied = (std::min)(size, buffer->space());
+    memcpy(buffer->begin, begin, copied);
+    buffer->begin += copied;
+    buffer->tail->append(begin + copied, end);
+    if (buffer->tail->size() > buffer->max_tail)
+        throw std::runtime_error("resumable print buffered more text than its limit");
+    return static_cast<int>(size);
+}
+
+inline void write_char(resumable_buffer* buffer, const char c) {
+    write_string(buffer, &c, &c + 1);
+}
+
+inline int write_string_unsafe(resumable_buffer* buffer, const char* text) {
+    return write_string(buffer, text, text + strlen(text));
+}
+
+template <typename... T>
+int write_printf(resumable_buffer* buffer, const char* format, T&&... args)
+{
+    return format_printf([buffer](const char* text, const char* text_end) { write_string(buffer, text, text_end); }, format, args...);
+}
+
+/**
+ * Progress of an argument that is printed in one go, e.g. a number or a generator
+ */
+struct whole_resume_state {
+    /** Prints the rest of the argument, and returns false if the buffer filled up before its end */
+    template <typename Dest, typename T>
+    bool resume(Dest dest, const json_print_spec& spec, const T& n) {
+        json_print_spec_arg(dest, spec, n);
+        return true;
+    }
+};
+
+/**
+ * Progress of a resumable print through an argument. Arguments without a
+ * specialization are printed in one go.
+ */
+template <typename T, typename = void>
+struct resume_state : whole_resume_state {};
+
+/**
+ * Progress through a string, which is escaped a buffer's worth at a time. Multibyte
+ * UTF-8 sequences aren't split, so they're checked the same as in one go.
+ */
+template <int Utf8Policy = JP_UTF8_POLICY, bool AsciiOnly = JP_ASCII_ONLY>
+struct string_resume_state {
+    size_t offset = 0;
+    bool started = false;
+
+    template <typename Dest>
+    bool resume_string(Dest dest, const char* begin, const char* end) {
+        // a trailing null terminator isn't printed
+        if (begin != end && *(end - 1) == '\0')
+            end--;
+        if (!started) {
+            write_char(dest, '"');
+            started = true;
+        }
+        while (begin + offset != end) {
+            if (dest->full())
+                return false;
+            const char* chunk = begin + offset;
+            const char* chunk_end = chunk + (std::min)(dest->space(), static_cast<size_t>(end - chunk));
+            while (chunk_end != end && (static_cast<unsigned char>(*chunk_end) & 0xC0) == 0x80)
+                chunk_end++;
+            json_print_escaped<Utf8Policy, AsciiOnly>(dest, chunk, chunk_end);
+            offset = chunk_end - begin;
+        }
+        write_char(dest, '"');
+        return true;
+    }
+};
+
+template <>
+struct resume_state<std::string> : string_resume_state<> {
+    template <typename Dest>
+    bool resume(Dest dest, const json_print_spec& spec, const std::string& n) {
+        if (spec.type == 's')
+            return whole_resume_state().resume(dest, spec, n);
+        return resume_string(dest, n.data(), n.data() + n.size());
+    }
+};
+
+#ifdef __cpp_lib_string_view
+template <>
+struct resume_state<std::string_view> : string_resume_state<> {
+    template <typename Dest>
+    bool resume(Dest dest, const json_print_spec& spec, std::string_view n) {
+        if (spec.type == 's')
+            return whole_resume_state().resume(dest, spec, n);
+        return resume_string(dest, n.data(), n.data() + n.size());
+    }
+};
+#endif
+
+template <>
+struct resume_state<const char*> : string_resume_state<> {
+    /** Length of the string, so that it's only measured once */
+    size_t length = 0;
+
+    template <typename Dest>
+    bool resume(Dest dest, const json_print_spec& spec, const char* n) {
+        if (spec.type == 's')
+            return whole_resume_state().resume(dest, spec, n);
+        if (!started)
+            length = strlen(n);
+        return resume_string(dest, n, n + length);
+    }
+};
+
+template <int Utf8Policy, bool AsciiOnly>
+struct resume_state<json_string_arg<Utf8Policy, AsciiOnly>> : string_resume_state<Utf8Policy, AsciiOnly> {
+    template <typename Dest>
+    bool resume(Dest dest, const json_print_spec& spec, const json_string_arg<Utf8Policy, AsciiOnly>& n) {
+        if (spec.type == 's')
+            return whole_resume_state().resume(dest, spec, n);
+        return this->resume_string(dest, n.begin, n.end);
+    }
+};
+
+/**
+ * Progress through raw JSON, which is copied a buffer's worth at a time
+ */
+template <>
+struct resume_state<json_raw_arg> {
+    size_t offset = 0;
+
+    template <typename Dest>
+    bool resume(Dest dest, const json_print_spec& spec, const json_raw_arg& n) {
+        if (spec.type == 's')
+            return whole_resume_state().resume(dest, spec, n);
+        const char* begin = n.begin + offset;
+        const char* end = begin + (std::min)(dest->space(), static_cast<size_t>(n.end - begin));
+        write_string(dest, begin, end);
+        offset = end - n.begin;
+        return end == n.end;
+    }
+};
+
+/** Returns the value of an element, which is the second half of a member for objects */
+template <typename T>
+inline const T& element_value(const T& element, std::false_type) {
+    return element;
+}
+
+template <typename K, typename V>
+inline const V& element_value(const std::pair<K, V>& member, std::true_type) {
+    return member.second;
+}
+
+/**
+ * Progress through the value of one element. It can only be resumed when the
+ * iterator refers to the element, rather than returning a copy of it.
+ */
+template <typename It, bool IsObject>
+using element_state = typename std::conditional<
+    std::is_lvalue_reference<decltype(*std::declval<It&>())>::value,
+    resume_state<typename std::decay<decltype(element_value(*std::declval<It&>(), std::integral_constant<bool, IsObject> {}))>::type>,
+    whole_resume_state>::type;
+
+/**
+ * Progress through an array or object, which is printed an element at a time
+ * and stops at the first element that doesn't fit, so each element is read once.
+ * Elements that are containers or strings are resumed in the same way.
+ */
+template <typename It, bool IsObject>
+struct element_resume_state {
+    It it;
+    size_t printed = 0;
+    bool started = false;
+    bool element_started = false;
+    element_state<It, IsObject> element;
+
+    template <typename Dest, typename T>
+    bool resume(Dest dest, const json_print_spec& spec, const T& n) {
+        if (spec.type == 's')
+            return whole_resume_state().resume(dest, spec, n);
+        if (!started) {
+            write_char(dest, IsObject ? '{' : '[');
+            it = n.begin();
+            started = true;
+        }
+        for (; it != n.end(); ++it, printed++) {
+            if (!element_started) {
+                if (dest->full())
+                    return false;
+                if (printed != 0)
+                    write_char(dest, ',');
+                resume_key(dest, std::integral_constant<bool, IsObject> {});
+                element_started = true;
+            }
+            if (!element.resume(dest, json_print_spec {}, element_value(*it, std::integral_constant<bool, IsObject> {})))
+                return false;
+            element = element_state<It, IsObject> {};
+            element_started = false;
+        }
+        write_char(dest, IsObject ? '}' : ']');
+        return true;
+    }
+
+private:
+    template <typename Dest>
+    void resume_key(Dest dest, std::true_type) {
+        json_print_arg(dest, it->first);
+        write_char(dest, ':');
+    }
+
+    template <typename Dest>
+    void resume_key(Dest, std::false_type) {}
+};
+
+template <typename T>
+struct resume_state<std::vector<T>> : element_resume_state<typename std::vector<T>::const_iterator, false> {};
+
+template <typename T, size_t N>
+struct resume_state<std::array<T, N>> : element_resume_state<typename std::array<T, N>::const_iterator, false> {};
+
+template <typename It>
+struct resume_state<json_range_arg<It>> : element_resume_state<It, false> {};
+
+template <typename K, typename T>
+struct resume_state<std::map<K, T>, typename std::enable_if<is_string_key<K>::value>::type>
+    : element_resume_state<typename std::map<K, T>::const_iterator, true> {};
+
+template <typename K, typename T>
+struct resume_state<std::unordered_map<K, T>, typename std::enable_if<is_string_key<K>::value>::type>
+    : element_resume_state<typename std::unordered_map<K, T>::const_iterator, true> {};
+
+/**
+ * Progress through a compiled format string and its arguments. Literal parts are
+ * copied a buffer's worth at a time, and arguments are resumed by their own state.
+ */
+template <typename... Ts>
+struct template_resume_state {
+    /** Literal parts and arguments alternate, starting and ending with a literal part */
+    static constexpr size_t piece_count = 2 * sizeof...(Ts) + 1;
+
+    std::tuple<resume_state<typename std::decay<Ts>::type>...> states;
+
+    /** Index of the literal part or argument being written, and how much of a literal part was written */
+    size_t piece = 0;
+    size_t part_offset = 0;
+
+    template <typename Dest>
+    bool resume_template(Dest dest, const json_print_context& context, const std::tuple<Ts...>& args) {
+        while (piece < piece_count) {
+            if (dest->full())
+                return false;
+            if (!resume_piece(dest, context, args, std::index_sequence_for<Ts...> {}))
+                return false;
+            piece++;
+        }
+        return true;
+    }
+
+private:
+    /** Writes the rest of the current piece, and returns false if the buffer filled up before its end */
+    template <typename Dest, size_t... Is>
+    bool resume_piece(Dest dest, const json_print_context& context, const std::tuple<Ts...>& args, std::index_sequence<Is...>) {
+        if (piece % 2 == 0) {
+            size_t part = piece / 2;
+            const char* begin = part_begin(context, part) + part_offset;
+            const char* end = context.parts[part + 1];
+            // format strings compiled with their null terminator end with '\0', which isn't printed
+            if (begin != end && *(end - 1) == '\0')
+                end--;
+            const char* copied = begin + (std::min)(dest->space(), static_cast<size_t>(end - begin));
+            write_string(dest, begin, copied);
+            part_offset = copied == end ? 0 : part_offset + (copied - begin);
+            return copied == end;
+        }
+
+        // print only the argument for this piece
+        size_t arg = piece / 2;
+        bool done = true;
+        std::initializer_list<bool> _ { (
+            arg == Is && (done = std::get<Is>(states).resume(dest, context.specs[Is], std::get<Is>(args)), false)
+        )... };
+        return done;
+    }
+};
+
+template <typename... Ts>
+struct resume_state<json_template_arg<Ts...>> : template_resume_state<Ts...> {
+    template <typename Dest>
+    bool resume(Dest dest, const json_print_spec& spec, const json_template_arg<Ts...>& n) {
+        if (spec.type == 's')
+            return whole_resume_state().resume(dest, spec, n);
+        return this->resume_template(dest, n.context, n.args);
+    }
+};
+
+}
+
+/**
+ * Print of a compiled format string and its arguments, which is written into
+ * a series of fixed-size buffers. Each call to write continues exactly where 
+ * the previous one stopped.
+ * 
+ * Nothing is printed twice. Literal parts, strings, raw JSON, sub-templates,
+ * arrays, ranges and maps are resumed where they stopped, and containers are
+ * printed an element at a time, stopping at the first element once the buffer
+ * is full, so each element is read once (input iterators can be used). Only the
+ * text of the argument or element that filled the buffer is kept for the next
+ * one, which is a few bytes for numbers. The exceptions are generators, which
+ * are called once for all of their elements, elements that iterators return by
+ * value, and map keys, which are kept whole. The kept text is limited to
+ * JP_MAX_RESUMABLE_TAIL bytes, or the limit set with set_max_buffered.
+ */
+template <typename... Ts>
+class json_resumable_print {
+public:
+    json_resumable_print(const json_print_context& context, std::tuple<Ts...> args)
+        : context(context), args(std::move(args)) {}
+
+    /**
+     * Writes as much of the remaining text as fits into the buffer
+     * @param buffer The buffer to write to
+     * @param size The size of the buffer in bytes
+     * @param written Receives the number of bytes written to the buffer
+     * @returns json_print_pending if the buffer was filled before the end of the text
+     * @throws std::runtime_error if more text than the limit had to be kept for the
+     * next buffer, after which the print can't be continued
+     */
+    json_print_status write(char* buffer, size_t size, size_t* written) {
+        // text that didn't fit into the last buffer comes first
+        size_t copied = (std::min)(size, tail.size() - tail_offset);
+        memcpy(buffer, tail.data() + tail_offset, copied);
+        tail_offset += copied;
+        if (tail_offset == tail.size()) {
+            tail.clear();
+            tail_offset = 0;
+        }
+
+        detail::resumable_buffer sbuffer = { buffer + copied, buffer + size, &tail, max_tail };
+        if (!finished && !sbuffer.full())
+            finished = state.resume_template(&sbuffer, context, args);
+        *written = sbuffer.begin - buffer;
+        return pending() ? json_print_pending : json_print_done;
+    }
+
+    /** Whether there is text left to write */
+    bool pending() const {
+        return !finished || tail_offset != tail.size();
+    }
+
+    /** The number of bytes that were printed but didn't fit, and are kept for the next buffer */
+    size_t buffered() const {
+        return tail.size() - tail_offset;
+    }
+
+    /** Limits the number of bytes kept for the next buffer, JP_MAX_RESUMABLE_TAIL by default */
+    void set_max_buffered(size_t bytes) {
+        max_tail = bytes;
+    }
+
+private:
+    json_print_context context;
+    std::tuple<Ts...> args;
+    detail::template_resume_state<Ts...> state;
+    bool finished = false;
+
+    /** Text that didn't fit into the last buffer, and how much of it was written since */
+    std::string tail;
+    size_t tail_offset = 0;
+    size_t max_tail = JP_MAX_RESUMABLE_TAIL;
+};
+
+/**
+ * Starts a resumable print of a compiled format string and its arguments. 
+ * Lvalue arguments are referenced, rvalue arguments are moved into the result.
+ */
+template <typename... Ts>
+inline json_resumable_print<Ts...> json_print_resumable(const json_print_context& context, Ts&&... args) {
+    return { context, std::tuple<Ts...>(std::forward<Ts>(args)...) };
+}
+
+}
@@ -0,0 +1,304 @@
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <errno.h>
+#include <fcntl.h>
+#include <mutex>
+#include <stdexcept>
+#include <string.h>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/*
+ * Optional sink that writes records into a series of files, switching to the next
+ * one at a size or record count threshold. Include after json_print.hpp. POSIX only.
+ */
+
+namespace JsonPrint {
+
+/**
+ * Rotation settings for a rotating file writer
+ */
+struct json_rotate_options {
+    /** Switch files once a file holds at least this many bytes, or 0 for no limit */
+    unsigned long long max_size = 64 * 1024 * 1024;
+
+    /** Switch files once a file holds this many records, or 0 for no limit */
+    unsigned long long max_records = 0;
+
+    /** fsync each file before it's renamed to its final name */
+    bool sync = true;
+
+    /** Size of the buffer, in bytes */
+    size_t buffer_size = 64 * 1024;
+};
+
+namespace detail {
+
+/**
+ * Sink that writes records to "<path>.<n>.tmp" and switches to the next file after
+ * the record that reaches a threshold, so files always end on a record boundary.
+ * The next file is opened ahead of time, and finished files are synced, closed and
+ * renamed to "<path>.<n>" on a background thread.
+ */
+class rotate_writer {
+public:
+    rotate_writer(const char* path, json_rotate_options options = {})
+        : path(path), options(options), buffer((std::max)(options.buffer_size, size_t(128))), end(buffer.data()) {
+        // continue after the files of earlier runs, rather than replace them
+        struct stat status;
+        while (stat(file_name(index, false).c_str(), &status) == 0)
+            index++;
+        fd = open_file(index);
+        if (fd < 0)
+            throw std::runtime_error("failed to open file");
+        next_index = index + 1;
+        thread = std::thread([this]() { work(); });
+    }
+
+    rotate_writer(const rotate_writer&) = delete;
+    rotate_writer& operator=(const rotate_writer&) = delete;
+
+    ~rotate_writer() {
+        try {
+            close();
+        } catch (...) {
+        }
+    }
+
+    /**
+     * Writes everything buffered so far to the current file
+     */
+    void flush() {
+        write_all(buffer.data(), end - buffer.data());
+        end = buffer.data();
+    }
+
+    /**
+     * Finishes the current file, waits for the background work to complete and
+     * removes the file that was opened ahead of time
+     */
+    void close() {
+        if (fd < 0)
+            return;
+        bool failed = false;
+        try {
+            flush();
+        } catch (...) {
+            failed = true;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            // a file without records, as after a rotation, is removed instead
+            finished.push_back({ fd, index, records == 0 });
+            stopping = true;
+            changed.notify_all();
+        }
+        fd = -1;
+        thread.join();
+        if (next_fd >= 0) {
+            ::close(next_fd);
+            unlink(file_name(next_index, true).c_str());
+            next_fd = -1;
+        }
+        if (failed || error != 0)
+            throw std::runtime_error("failed to write file");
+    }
+
+    /** Called after each record is printed, and switches files at a threshold */
+    void end_record() {
+        records++;
+        unsigned long long size = written + (end - buffer.data());
+        if ((options.max_records != 0 && records >= options.max_records) || (options.max_size != 0 && size >= options.max_size))
+            rotate();
+    }
+
+    /** Name of the file currently written, before it's renamed */
+    std::string current_file() const {
+        return file_name(index, true);
+    }
+
+    void write(const char* begin, const char* end) {
+        size_t size = end - begin;
+        if (size > static_cast<size_t>(buffer.data() + buffer.size() - this->end)) {
+            flush();
+            if (size >= buffer.size()) {
+                write_all(begin, size);
+                return;
+            }
+        }
+        memcpy(this->end, begin, size);
+        this->end += size;
+    }
+
+    void write(char c) {
+        if (end == buffer.data() + buffer.size())
+            flush();
+        *end++ = c;
+    }
+
+    template <typename... T>
+    int write_printf(const char* format, T&&... args) {
+        // numbers are printed straight into the buffer
+        if (buffer.data() + buffer.size() - end < printf_buffer_size)
+            flush();
+        int result = snprintf(end, printf_buffer_size, format, args...);
+        if (result >= 0 && result < printf_buffer_size) {
+            end += result;
+            return result;
+        }
+        // longer text, like "%.99f" of a large number, is formatted on the side
+        return format_printf([this](const char* text, const char* text_end) { write(text, text_end); }, format, args...);
+    }
+
+private:
+    struct finished_file {
+        int fd;
+        unsigned long long index;
+        bool empty;
+    };
+
+    std::string file_name(unsigned long long index, bool partial) const {
+        return path + "." + std::to_string(index) + (partial ? ".tmp" : "");
+    }
+
+    int open_file(unsigned long long index) const {
+        return ::open(file_name(index, true).c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    }
+
+    /** Switches to the file opened ahead of time, and hands the current one to the background thread */
+    void rotate() {
+        flush();
+        std::unique_lock<std::mutex> lock(mutex);
+        // only waits if files are rotated faster than they can be opened
+        changed.wait(lock, [this]() { return next_fd >= 0 || error != 0; });
+        if (error != 0)
+            throw std::runtime_error("failed to rotate file");
+        finished.push_back({ fd, index, false });
+        fd = next_fd;
+        index = next_index;
+        next_fd = -1;
+        next_index = index + 1;
+        changed.notify_all();
+        lock.unlock();
+        written = 0;
+        records = 0;
+    }
+
+    /** Opens the next file and finishes the rotated ones, on the background thread */
+    void work() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            changed.wait(lock, [this]() { return !finished.empty() || (next_fd < 0 && error == 0) || stopping; });
+            if (!finished.empty()) {
+                finished_file file = finished.front();
+                finished.pop_front();
+                lock.unlock();
+                int result = finish(file);
+                lock.lock();
+                if (result != 0)
+                    error = result;
+                continue;
+            }
+            if (stopping)
+                return;
+            unsigned long long opening = next_index;
+            lock.unlock();
+            int opened = open_file(opening);
+            int result = opened < 0 ? errno : 0;
+            lock.lock();
+            next_fd = opened;
+            if (result != 0)
+                error = result;
+            changed.notify_all();
+        }
+    }
+
+    int finish(const finished_file& file) {
+        int result = 0;
+        if (options.sync && !file.empty && fsync(file.fd) != 0)
+            result = errno;
+        if (::close(file.fd) != 0 && result == 0)
+            result = errno;
+        if (file.empty)
+            unlink(file_name(file.index, true).c_str());
+        else if (rename(file_name(file.index, true).c_str(), file_name(file.index, false).c_str()) != 0 && result == 0)
+            result = errno;
+        return result;
+    }
+
+    void write_all(const char* data, size_t size) {
+        while (size != 0) {
+            ssize_t result = ::write(fd, data, size);
+            if (result < 0 && errno == EINTR)
+                continue;
+            if (result < 0)
+                throw std::runtime_error("failed to write file");
+            data += result;
+            size -= result;
+            written += result;
+        }
+    }
+
+    std::string path;
+    json_rotate_options options;
+    std::vector<char> buffer;
+    char* end;
+    int fd = -1;
+    unsigned long long index = 1;
+    unsigned long long written = 0;
+    unsigned long long records = 0;
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable changed;
+    int next_fd = -1;
+    unsigned long long next_index = 0;
+    std::deque<finished_file> finished;
+    bool stopping = false;
+    int error = 0;
+};
+
+inline void write_char(rotate_writer* writer, const char c) {
+    writer->write(c);
+}
+
+inline int write_string(rotate_writer* writer, const char* begin, const char* end) {
+    writer->write(begin, end);
+    return static_cast<int>(end - begin);
+}
+
+inline int write_string_unsafe(rotate_writer* writer, const char* text) {
+    return write_string(writer, text, text + strlen(text));
+}
+
+template <typename... T>
+int write_printf(rotate_writer* writer, const char* format, T&&... args) {
+    return writer->write_printf(format, std::forward<T>(args)...);
+}
+
+}
+
+/**
+ * Writer that prints records into numbered files, and switches to the next file at a
+ * size or record count threshold, always between records. Files are named
+ * "<path>.<n>.tmp" while they're written, and renamed to "<path>.<n>" when complete.
+ */
+using json_rotating_writer = detail::rotate_writer;
+
+/**
+ * Prints one record of JSON text into a rotating file writer
+ */
+template <typename... Ts>
+inline void json_rotate_print(json_rotating_writer& writer, const json_print_context& context, Ts&&... args) {
+    detail::json_print(&writer, context, std::forward<Ts>(args)...);
+    writer.end_record();
+}
+
+}
+
+#define json_rotate_print_c(writer, format, ...) ([&](auto&&... jp_args){ constexpr auto x = JsonPrint::compile(format); JP_CHECK_SPREAD(x, jp_args); JsonPrint::json_rotate_print(writer, x, std::forward<decltype(jp_args)>(jp_args)...); }(__VA_ARGS__))
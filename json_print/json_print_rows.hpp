@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <cstdio>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string.h>
+#include <tuple>
+#include <utility>
+
+/*
+ * Optional printing of columns as rows of JSON text. Include after json_print.hpp.
+ */
+
+namespace JsonPrint {
+namespace detail {
+
+/** Size of the buffer that rows are rendered into before they're written to a file */
+constexpr size_t rows_batch_size = 64 * 1024;
+
+/**
+ * Sink that collects rows for a file, and writes them with one fwrite per batch.
+ * Numbers are printed straight into the buffer.
+ */
+class row_batch {
+public:
+    row_batch(FILE* file) : file(file), buffer(new char[rows_batch_size]), end(buffer.get()) {}
+
+    row_batch(const row_batch&) = delete;
+    row_batch& operator=(const row_batch&) = delete;
+
+    void flush() {
+        if (end != buffer.get())
+            fwrite(buffer.get(), end - buffer.get(), 1, file);
+        end = buffer.get();
+    }
+
+    /** Writes the batch once it's nearly full, or at the last row */
+    void end_row(bool last) {
+        if (last || buffer.get() + rows_batch_size - end < 1024)
+            flush();
+    }
+
+    void write(const char* begin, const char* end) {
+        size_t size = end - begin;
+        if (size > static_cast<size_t>(buffer.get() + rows_batch_size - this->end)) {
+            flush();
+            if (size >= rows_batch_size) {
+                fwrite(begin, size, 1, file);
+                return;
+            }
+        }
+        memcpy(this->end, begin, size);
+        this->end += size;
+    }
+
+    void write(char c) {
+        if (end == buffer.get() + rows_batch_size)
+            flush();
+        *end++ = c;
+    }
+
+    template <typename... T>
+    int write_printf(const char* format, T&&... args) {
+        if (buffer.get() + rows_batch_size - end < printf_buffer_size)
+            flush();
+        int result = snprintf(end, printf_buffer_size, format, args...);
+        if (result >= 0 && result < printf_buffer_size) {
+            end += result;
+            return result;
+        }
+        // longer text, like "%.99f" of a large number, is formatted on the side
+        return format_printf([this](const char* text, const char* text_end) { write(text, text_end); }, format, args...);
+    }
+
+private:
+    FILE* file;
+    std::unique_ptr<char[]> buffer;
+    char* end;
+};
+
+inline void write_char(row_batch* batch, const char c) {
+    batch->write(c);
+}
+
+inline int write_string(row_batch* batch, const char* begin, const char* end) {
+    batch->write(begin, end);
+    return static_cast<int>(end - begin);
+}
+
+inline int write_string_unsafe(row_batch* batch, const char* text) {
+    return write_string(batch, text, text + strlen(text));
+}
+
+template <typename... T>
+int write_printf(row_batch* batch, const char* format, T&&... args) {
+    return batch->write_printf(format, std::forward<T>(args)...);
+}
+
+template <typename C>
+using column_value_t = typename std::iterator_traits<decltype(std::begin(std::declval<const C&>()))>::value_type;
+
+/**
+ * Returns the number of rows in the columns
+ * @throws std::runtime_error if the columns don't have the same length
+ */
+template <typename C, typename... Cs>
+inline size_t column_rows(const C& first, const Cs&... columns) {
+    size_t rows = first.size();
+    std::initializer_list<bool> _ { (
+        columns.size() != rows ? throw std::runtime_error("columns have different lengths") : false
+    )... };
+    return rows;
+}
+
+/**
+ * Prints the rows of the columns with a compiled row template, each followed by a
+ * newline. The columns are walked in lockstep with one iterator each, and the
+ * specifier of each column is resolved once for the whole loop when inlined.
+ */
+template <typename Dest, typename Flush, size_t... Is, typename... Cs>
+inline void json_print_rows_indexed(Dest dest, Flush flush, const json_print_context& context, std::index_sequence<Is...>, const Cs&... columns) {
+    static_assert(sizeof...(Cs) != 0, "expected at least one column");
+    if (sizeof...(Cs) + 1 != context.count)
+        throw std::runtime_error("number of columns doesn't match the placeholders");
+    size_t rows = column_rows(columns...);
+    auto its = std::make_tuple(std::begin(columns)...);
+    for (size_t row = 0; row != rows; row++) {
+        json_print_part(dest, context.parts[0], context.parts[1]);
+        std::initializer_list<bool> _ { (
+            json_print_spec_arg(dest, context.specs[Is], static_cast<const column_value_t<Cs>&>(*std::get<Is>(its))),
+            json_print_part(dest, part_begin(context, Is + 1), context.parts[Is + 2]),
+            ++std::get<Is>(its),
+            false
+        )... };
+        write_char(dest, '\n');
+        flush(false);
+    }
+    flush(true);
+}
+
+}
+
+/**
+ * Prints one row of JSON text per element of the columns, each followed by a newline.
+ * The i-th placeholder of the row template is replaced by the element of the i-th column.
+ * Rows are buffered and written to the file in batches, rather than per row.
+ * @throws std::runtime_error if the columns don't match the placeholders, or don't have the same length
+ */
+template <typename... Cs>
+inline void json_fprint_rows(FILE* file, const json_print_context& context, const Cs&... columns) {
+    detail::row_batch batch(file);
+    detail::json_print_rows_indexed(&batch, [&](bool last) { batch.end_row(last); }, context, std::index_sequence_for<Cs...> {}, columns...);
+}
+
+template <typename... Cs>
+inline void json_print_rows(const json_print_context& context, const Cs&... columns) {
+    json_fprint_rows(stdout, context, columns...);
+}
+
+/**
+ * Prints the rows of the columns to a buffer, truncated if they don't fit, and
+ * null-terminated
+ */
+template <typename... Cs>
+inline void json_sprint_rows(char* buffer, size_t size, const json_print_context& context, const Cs&... columns) {
+    if (size == 0)
+        return;
+    detail::string_buffer sbuffer = { buffer, buffer + size - 1 };
+    detail::json_print_rows_indexed(&sbuffer, [](bool) {}, context, std::index_sequence_for<Cs...> {}, columns...);
+    *sbuffer.begin = '\0';
+}
+
+}
+
+// spread placeholders are checked against the element type of their column
+#define json_print_rows_c(format, ...) ([&](auto&&... jp_args){ constexpr auto x = JsonPrint::compile(format); static_assert(JsonPrint::detail::spreads_match<JsonPrint::detail::column_value_t<typename std::decay<decltype(jp_args)>::type>...>(x), "expected a map or a range of pairs with string keys for '...?'"); JsonPrint::json_print_rows(x, std::forward<decltype(jp_args)>(jp_args)...); }(__VA_ARGS__))
+#define json_fprint_rows_c(file, format, ...) ([&](auto&&... jp_args){ constexpr auto x = JsonPrint::compile(format); static_assert(JsonPrint::detail::spreads_match<JsonPrint::detail::column_value_t<typename std::decay<decltype(jp_args)>::type>...>(x), "expected a map or a range of pairs with string keys for '...?'"); JsonPrint::json_fprint_rows(file, x, std::forward<decltype(jp_args)>(jp_args)...); }(__VA_ARGS__))
+#define json_sprint_rows_c(buffer, size, format, ...) ([&](auto&&... jp_args){ constexpr auto x = JsonPrint::compile(format); static_assert(JsonPrint::detail::spreads_match<JsonPrint::detail::column_value_t<typename std::decay<decltype(jp_args)>::type>...>(x), "expected a map or a range of pairs with string keys for '...?'"); JsonPrint::json_sprint_rows(buffer, size, x, std::forward<decltype(jp_args)>(jp_args)...); }(__VA_ARGS__))
@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string.h>
+
+/*
+ * Optional per call site statistics, collected by the printing macros when JP_STATS
+ * is defined. Include after json_print.hpp.
+ */
+
+#ifndef JP_STATS_BUCKETS
+#define JP_STATS_BUCKETS 32
+#endif
+
+namespace JsonPrint {
+
+/**
+ * Statistics for one call site of the printing macros. Each site registers 
+ * a static instance the first time it's reached.
+ */
+struct json_print_site_stats {
+    const char* file;
+    int line;
+    const char* format;
+
+    std::atomic<unsigned long long> calls { 0 };
+    std::atomic<unsigned long long> bytes { 0 };
+    std::atomic<unsigned long long> nanoseconds { 0 };
+
+    /** Number of calls taking [2^i, 2^(i+1)) nanoseconds, the last bucket includes longer calls */
+    std::atomic<unsigned long long> histogram[JP_STATS_BUCKETS];
+
+    /** Next site in the registry */
+    json_print_site_stats* next = nullptr;
+
+    json_print_site_stats(const char* file, int line, const char* format);
+
+    void record(size_t written, unsigned long long elapsed) {
+        size_t bucket = 0;
+        for (unsigned long long n = elapsed; n > 1 && bucket < JP_STATS_BUCKETS - 1; n >>= 1)
+            bucket++;
+        calls.fetch_add(1, std::memory_order_relaxed);
+        bytes.fetch_add(written, std::memory_order_relaxed);
+        nanoseconds.fetch_add(elapsed, std::memory_order_relaxed);
+        histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+namespace detail {
+
+/**
+ * Head of the linked list of registered call sites
+ */
+inline std::atomic<json_print_site_stats*>& stats_registry() {
+    static std::atomic<json_print_site_stats*> head { nullptr };
+    return head;
+}
+
+/**
+ * Sink that counts the bytes written to another sink
+ */
+template <typename Dest>
+struct counting_sink {
+    Dest dest;
+    size_t count;
+};
+
+template <typename Dest>
+inline void write_char(counting_sink<Dest>* sink, const char c) {
+    sink->count++;
+    write_char(sink->dest, c);
+}
+
+template <typename Dest>
+inline int write_string(counting_sink<Dest>* sink, const char* begin, const char* end) {
+    sink->count += end - begin;
+    return write_string(sink->dest, begin, end);
+}
+
+template <typename Dest>
+inline int write_string_unsafe(counting_sink<Dest>* sink, const char* text) {
+    return write_string(sink, text, text + strlen(text));
+}
+
+template <typename Dest, typename... T>
+int write_printf(counting_sink<Dest>* sink, const char* format, T&&... args) {
+    int result = write_printf(sink->dest, format, std::forward<T>(args)...);
+    sink->count += (std::max)(result, 0);
+    return result;
+}
+
+}
+
+inline json_print_site_stats::json_print_site_stats(const char* file, int line, const char* format)
+    : file(file), line(line), format(format) {
+    for (std::atomic<unsigned long long>& bucket : histogram)
+        bucket.store(0, std::memory_order_relaxed);
+    std::atomic<json_print_site_stats*>& head = detail::stats_registry();
+    next = head.load();
+    while (!head.compare_exchange_weak(next, this)) {}
+}
+
+/**
+ * Returns the most recently registered call site. Older sites follow through "next".
+ */
+inline const json_print_site_stats* json_print_sites() {
+    return detail::stats_registry().load();
+}
+
+namespace detail {
+
+template <typename Dest, typename... Ts>
+inline void json_print_measured(json_print_site_stats& site, Dest dest, const json_print_context& context, Ts&&... args) {
+    auto start = std::chrono::steady_clock::now();
+    counting_sink<Dest> sink = { dest, 0 };
+    json_print(&sink, context, std::forward<Ts>(args)...);
+    site.record(sink.count, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+template <typename... Ts>
+inline void json_sprint_measured(json_print_site_stats& site, char* buffer, size_t size, const json_print_context& context, Ts&&... args) {
+    if (size == 0)
+        return;
+    string_buffer sbuffer = { buffer, buffer + size - 1 };
+    json_print_measured(site, &sbuffer, context, std::forward<Ts>(args)...);
+    *sbuffer.begin = '\0';
+}
+
+}
+
+/**
+ * Prints the statistics of every call site as a JSON array
+ */
+inline void json_fprint_stats(FILE* file) {
+    constexpr auto site_context = compile(R"({"file": ?, "line": ?, "format": ?, "calls": ?, "bytes": ?, "nanoseconds": ?, "histogram": ?})");
+    constexpr auto context = compile("?\n");
+    detail::json_print(file, context, json_generator([&](auto emit) {
+        for (const json_print_site_stats* site = json_print_sites(); site != nullptr; site = site->next) {
+            emit(json_template(site_context, site->file, site->line, site->format, 
+                site->calls.load(), site->bytes.load(), site->nanoseconds.load(),
+                json_generator([&](auto emit_bucket) {
+                    for (const std::atomic<unsigned long long>& bucket : site->histogram)
+                        emit_bucket(bucket.load());
+                })));
+        }
+    }));
+}
+
+}
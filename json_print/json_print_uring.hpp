@@ -0,0 +1,430 @@
+#include <algorithm>
+#include <cstdio>
+#include <deque>
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <stdexcept>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <vector>
+
+/*
+ * Optional sink that writes to a file descriptor asynchronously with io_uring, through
+ * the raw system calls so that liburing isn't needed. Include after json_print.hpp.
+ * Linux only.
+ */
+
+namespace JsonPrint {
+
+/**
+ * Buffering settings for an io_uring writer
+ */
+struct json_uring_options {
+    /** Size of each buffer, in bytes */
+    size_t buffer_size = 64 * 1024;
+
+    /** Number of buffers in the pool, which is how many writes can be in flight */
+    unsigned buffers = 4;
+
+    /** If io_uring isn't available, write synchronously instead of throwing */
+    bool fallback = true;
+};
+
+namespace detail {
+
+/**
+ * Submission and completion queues of an io_uring instance, mapped from the kernel
+ */
+class uring {
+public:
+    uring() = default;
+    uring(const uring&) = delete;
+    uring& operator=(const uring&) = delete;
+
+    ~uring() {
+        if (sqes != nullptr)
+            munmap(sqes, sqes_size);
+        if (cq_ring != nullptr && cq_ring != sq_ring)
+            munmap(cq_ring, cq_ring_size);
+        if (sq_ring != nullptr)
+            munmap(sq_ring, sq_ring_size);
+        if (fd >= 0)
+            ::close(fd);
+    }
+
+    /** Sets up the queues, and returns false if io_uring isn't available */
+    bool open(unsigned entries) {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+        fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (fd < 0)
+            return false;
+
+        sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap)
+            sq_ring_size = cq_ring_size = (std::max)(sq_ring_size, cq_ring_size);
+        sq_ring = map(sq_ring_size, IORING_OFF_SQ_RING);
+        cq_ring = single_mmap ? sq_ring : map(cq_ring_size, IORING_OFF_CQ_RING);
+        sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        void* mapped_sqes = map(sqes_size, IORING_OFF_SQES);
+        if (sq_ring == nullptr || cq_ring == nullptr || mapped_sqes == nullptr)
+            return false;
+        sqes = static_cast<io_uring_sqe*>(mapped_sqes);
+
+        char* sq = static_cast<char*>(sq_ring);
+        sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_mask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        char* cq = static_cast<char*>(cq_ring);
+        cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    /** Registers buffers for IORING_OP_WRITE_FIXED, and returns false if that's not allowed */
+    bool register_buffers(const struct iovec* buffers, unsigned count) {
+        return syscall(__NR_io_uring_register, fd, IORING_REGISTER_BUFFERS, buffers, count) == 0;
+    }
+
+    /** Next submission queue entry to fill in. The queue must have room for it. */
+    io_uring_sqe* next() {
+        unsigned tail = *sq_tail + unsubmitted;
+        unsigned index = tail & sq_mask;
+        sq_array[index] = index;
+        unsubmitted++;
+        io_uring_sqe* sqe = &sqes[index];
+        memset(sqe, 0, sizeof(*sqe));
+        return sqe;
+    }
+
+    /**
+     * Submits the entries filled in since the last call, and waits until at least
+     * min_complete completions are available
+     */
+    void enter(unsigned min_complete) {
+        if (unsubmitted == 0 && min_complete == 0)
+            return;
+        __atomic_store_n(sq_tail, *sq_tail + unsubmitted, __ATOMIC_RELEASE);
+        unsigned count = unsubmitted;
+        unsubmitted = 0;
+        while (true) {
+            long result = syscall(__NR_io_uring_enter, fd, count, min_complete, min_complete != 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+            if (result >= 0 || errno != EINTR)
+                break;
+            count = 0;
+        }
+    }
+
+    /** Calls f(user_data, result) for each completion available, without waiting */
+    template <typename F>
+    void reap(F&& f) {
+        unsigned head = *cq_head;
+        unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != tail; head++) {
+            const io_uring_cqe& cqe = cqes[head & cq_mask];
+            f(cqe.user_data, cqe.res);
+        }
+        __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+    }
+
+private:
+    void* map(size_t size, off_t offset) {
+        void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+        return memory == MAP_FAILED ? nullptr : memory;
+    }
+
+    int fd = -1;
+    void* sq_ring = nullptr;
+    void* cq_ring = nullptr;
+    size_t sq_ring_size = 0;
+    size_t cq_ring_size = 0;
+    io_uring_sqe* sqes = nullptr;
+    size_t sqes_size = 0;
+    unsigned* sq_tail = nullptr;
+    unsigned sq_mask = 0;
+    unsigned* sq_array = nullptr;
+    unsigned unsubmitted = 0;
+    unsigned* cq_head = nullptr;
+    unsigned* cq_tail = nullptr;
+    unsigned cq_mask = 0;
+    io_uring_cqe* cqes = nullptr;
+};
+
+/**
+ * Sink that formats into one buffer of a pool while the filled ones are written by
+ * io_uring. Printing only waits for a write when every buffer is in flight. Regular
+ * files are written at explicit offsets, with all buffers in flight at once, and
+ * pipes, sockets and files opened with O_APPEND one buffer at a time, in order.
+ */
+class uring_writer {
+public:
+    uring_writer(int fd, json_uring_options options = {}) : fd(fd), options(options) {
+        unsigned count = (std::max)(options.buffers, 2u);
+        size_t size = (std::max)(options.buffer_size, size_t(128));
+        storage.resize(count * size);
+        for (unsigned i = 0; i < count; i++) {
+            block b;
+            b.buffer.iov_base = storage.data() + i * size;
+            b.buffer.iov_len = size;
+            blocks.push_back(b);
+        }
+
+        off_t position = (fcntl(fd, F_GETFL) & O_APPEND) != 0 ? -1 : lseek(fd, 0, SEEK_CUR);
+        offset = position < 0 ? -1 : position;
+        max_in_flight = offset < 0 ? 1 : count;
+
+        std::vector<struct iovec> vectors;
+        for (const block& b : blocks)
+            vectors.push_back(b.buffer);
+        if (ring.open(count)) {
+            async = true;
+            registered = ring.register_buffers(vectors.data(), count);
+        } else if (!options.fallback) {
+            throw std::runtime_error("io_uring is not available");
+        }
+
+        for (unsigned i = count; i > 1; i--)
+            free_blocks.push_back(i - 1);
+        use(0);
+    }
+
+    uring_writer(const uring_writer&) = delete;
+    uring_writer& operator=(const uring_writer&) = delete;
+
+    ~uring_writer() {
+        try {
+            flush();
+        } catch (...) {
+        }
+    }
+
+    /**
+     * Writes the current buffer, and waits until everything printed so far is written
+     */
+    void flush() {
+        if (end != begin)
+            submit();
+        while (async && (in_flight != 0 || !queued.empty())) {
+            ring.enter(1);
+            pump();
+        }
+        if (async && offset >= 0)
+            lseek(fd, offset, SEEK_SET);
+        check();
+    }
+
+    /** Whether writes go through io_uring, or fell back to synchronous writes */
+    bool is_uring() const {
+        return async;
+    }
+
+    /** Bytes written to the file descriptor so far */
+    unsigned long long written() const {
+        return total;
+    }
+
+    void write(const char* begin, const char* end) {
+        while (begin != end) {
+            if (this->end == limit)
+                submit();
+            size_t count = (std::min)(static_cast<size_t>(end - begin), static_cast<size_t>(limit - this->end));
+            memcpy(this->end, begin, count);
+            this->end += count;
+            begin += count;
+        }
+    }
+
+    void write(char c) {
+        if (end == limit)
+            submit();
+        *end++ = c;
+    }
+
+    template <typename... T>
+    int write_printf(const char* format, T&&... args) {
+        // numbers are printed straight into the buffer
+        if (limit - end < printf_buffer_size)
+            submit();
+        int result = snprintf(end, printf_buffer_size, format, args...);
+        if (result >= 0 && result < printf_buffer_size) {
+            end += result;
+            return result;
+        }
+        // longer text, like "%.99f" of a large number, is formatted on the side
+        return format_printf([this](const char* text, const char* text_end) { write(text, text_end); }, format, args...);
+    }
+
+private:
+    struct block {
+        /** Whole buffer, as registered */
+        struct iovec buffer;
+        /** Part of the buffer that's left to write, for IORING_OP_WRITEV */
+        struct iovec rest;
+        size_t size = 0;
+        size_t done = 0;
+        long long offset = -1;
+    };
+
+    void use(unsigned index) {
+        current = index;
+        begin = static_cast<char*>(blocks[index].buffer.iov_base);
+        end = begin;
+        limit = begin + blocks[index].buffer.iov_len;
+    }
+
+    /** Queues the current buffer for writing, and continues in a free one */
+    void submit() {
+        size_t size = end - begin;
+        if (!async) {
+            write_all(begin, size);
+            end = begin;
+            return;
+        }
+        check();
+        block& b = blocks[current];
+        b.size = size;
+        b.done = 0;
+        b.offset = offset;
+        if (offset >= 0)
+            offset += size;
+        queued.push_back(current);
+        pump();
+        while (free_blocks.empty()) {
+            ring.enter(1);
+            pump();
+        }
+        use(free_blocks.back());
+        free_blocks.pop_back();
+    }
+
+    /** Handles completed writes, and submits queued buffers while there's room in flight */
+    void pump() {
+        ring.reap([this](unsigned long long index, int result) {
+            block& b = blocks[index];
+            if (result < 0 && result != -EINTR && result != -EAGAIN) {
+                error = -result;
+                b.done = b.size;
+            } else if (result > 0) {
+                b.done += result;
+                total += result;
+            }
+            if (b.done < b.size) {
+                // write the rest of a short write
+                prepare(static_cast<unsigned>(index));
+                return;
+            }
+            in_flight--;
+            free_blocks.push_back(static_cast<unsigned>(index));
+        });
+        while (in_flight < max_in_flight && !queued.empty()) {
+            prepare(queued.front());
+            queued.pop_front();
+            in_flight++;
+        }
+        ring.enter(0);
+    }
+
+    void prepare(unsigned index) {
+        block& b = blocks[index];
+        io_uring_sqe* sqe = ring.next();
+        sqe->fd = fd;
+        sqe->off = b.offset < 0 ? static_cast<unsigned long long>(-1) : b.offset + b.done;
+        sqe->user_data = index;
+        if (registered) {
+            sqe->opcode = IORING_OP_WRITE_FIXED;
+            sqe->addr = reinterpret_cast<unsigned long long>(static_cast<char*>(b.buffer.iov_base) + b.done);
+            sqe->len = static_cast<unsigned>(b.size - b.done);
+            sqe->buf_index = static_cast<unsigned short>(index);
+        } else {
+            b.rest.iov_base = static_cast<char*>(b.buffer.iov_base) + b.done;
+            b.rest.iov_len = b.size - b.done;
+            sqe->opcode = IORING_OP_WRITEV;
+            sqe->addr = reinterpret_cast<unsigned long long>(&b.rest);
+            sqe->len = 1;
+        }
+    }
+
+    void write_all(const char* data, size_t size) {
+        while (size != 0) {
+            ssize_t result = ::write(fd, data, size);
+            if (result < 0 && errno == EINTR)
+                continue;
+            if (result < 0)
+                throw std::runtime_error("failed to write to file descriptor");
+            data += result;
+            size -= result;
+            total += result;
+        }
+    }
+
+    void check() {
+        if (error != 0)
+            throw std::runtime_error("failed to write to file descriptor");
+    }
+
+    int fd;
+    json_uring_options options;
+    std::vector<char> storage;
+    std::vector<block> blocks;
+    uring ring;
+    bool async = false;
+    bool registered = false;
+    std::vector<unsigned> free_blocks;
+    std::deque<unsigned> queued;
+    unsigned in_flight = 0;
+    unsigned max_in_flight = 1;
+    long long offset = -1;
+    unsigned current = 0;
+    char* begin = nullptr;
+    char* end = nullptr;
+    char* limit = nullptr;
+    unsigned long long total = 0;
+    int error = 0;
+};
+
+inline void write_char(uring_writer* writer, const char c) {
+    writer->write(c);
+}
+
+inline int write_string(uring_writer* writer, const char* begin, const char* end) {
+    writer->write(begin, end);
+    return static_cast<int>(end - begin);
+}
+
+inline int write_string_unsafe(uring_writer* writer, const char* text) {
+    return write_string(writer, text, text + strlen(text));
+}
+
+template <typename... T>
+int write_printf(uring_writer* writer, const char* format, T&&... args) {
+    return writer->write_printf(format, std::forward<T>(args)...);
+}
+
+}
+
+/**
+ * Writer that prints JSON text into a pool of buffers, and writes the filled ones to
+ * a file descriptor with io_uring while printing continues. The buffers are written
+ * when the writer is destroyed, but the file descriptor isn't closed.
+ */
+using json_uring_writer = detail::uring_writer;
+
+/**
+ * Prints one record of JSON text into an io_uring writer
+ */
+template <typename... Ts>
+inline void json_uring_print(json_uring_writer& writer, const json_print_context& context, Ts&&... args) {
+    detail::json_print(&writer, context, std::forward<Ts>(args)...);
+}
+
+}
+
+#define json_uring_print_c(writer, format, ...) ([&](auto&&... jp_args){ constexpr auto x = JsonPrint::compile(format); JP_CHECK_SPREAD(x, jp_args); JsonPrint::json_uring_print(writer, x, std::forward<decltype(jp_args)>(jp_args)...); }(__VA_ARGS__))
@@ -0,0 +1,219 @@
+#include <algorithm>
+#include <cstdio>
+#include <errno.h>
+#include <stdexcept>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+#include <zlib.h>
+
+/*
+ * Optional sink that compresses output with zlib while printing. Include after
+ * json_print.hpp, and link with zlib.
+ */
+
+namespace JsonPrint {
+
+/**
+ * When a compressed writer flushes its compressed data to the file
+ */
+enum json_gzip_flush {
+    /** Only when buffers fill up, and when closed. Compresses best. */
+    json_gzip_flush_none,
+    /** After every record, so each record can be decompressed as soon as it's written */
+    json_gzip_flush_record
+};
+
+/**
+ * Compression settings for a compressed writer
+ */
+struct json_gzip_options {
+    /** zlib compression level, from 0 (none) to 9 (best) */
+    int level = Z_DEFAULT_COMPRESSION;
+
+    /** Write a gzip header and trailer if true, or a zlib header and trailer if false */
+    bool gzip = true;
+
+    /** When compressed data is flushed */
+    json_gzip_flush flush = json_gzip_flush_none;
+
+    /** Size of the uncompressed and compressed buffers, in bytes */
+    size_t buffer_size = 64 * 1024;
+};
+
+namespace detail {
+
+/**
+ * Sink that buffers text, compresses it in a streaming deflate stream,
+ * and writes the compressed blocks to a FILE* or a file descriptor
+ */
+class gzip_writer {
+public:
+    gzip_writer(FILE* file, json_gzip_options options = {}) : file(file), fd(-1), options(options) {
+        init();
+    }
+
+    gzip_writer(int fd, json_gzip_options options = {}) : file(nullptr), fd(fd), options(options) {
+        init();
+    }
+
+    gzip_writer(const gzip_writer&) = delete;
+    gzip_writer& operator=(const gzip_writer&) = delete;
+
+    ~gzip_writer() {
+        try {
+            close();
+        } catch (...) {
+            deflateEnd(&stream);
+        }
+    }
+
+    /**
+     * Compresses the buffered text and writes it, so that everything written
+     * so far can be decompressed
+     */
+    void flush() {
+        deflate_input(Z_SYNC_FLUSH);
+    }
+
+    /**
+     * Ends the compressed stream. Doesn't close the file.
+     */
+    void close() {
+        if (closed)
+            return;
+        deflate_input(Z_FINISH);
+        deflateEnd(&stream);
+        closed = true;
+    }
+
+    /** Called after each record is printed */
+    void end_record() {
+        if (options.flush == json_gzip_flush_record)
+            flush();
+    }
+
+    /** Uncompressed bytes written so far */
+    unsigned long long total_in() const {
+        return stream.total_in + (input_end - input.data());
+    }
+
+    /** Compressed bytes written so far */
+    unsigned long long total_out() const {
+        return stream.total_out;
+    }
+
+    void write(const char* begin, const char* end) {
+        while (begin != end) {
+            if (input_end == input.data() + input.size())
+                deflate_input(Z_NO_FLUSH);
+            size_t size = (std::min)(static_cast<size_t>(end - begin), static_cast<size_t>(input.data() + input.size() - input_end));
+            memcpy(input_end, begin, size);
+            input_end += size;
+            begin += size;
+        }
+    }
+
+    void write(char c) {
+        if (input_end == input.data() + input.size())
+            deflate_input(Z_NO_FLUSH);
+        *input_end++ = c;
+    }
+
+    template <typename... T>
+    int write_printf(const char* format, T&&... args) {
+        return format_printf([this](const char* text, const char* text_end) { write(text, text_end); }, format, args...);
+    }
+
+private:
+    void init() {
+        input.resize((std::max)(options.buffer_size, size_t(128)));
+        output.resize((std::max)(options.buffer_size, size_t(128)));
+        input_end = input.data();
+        stream = z_stream();
+        if (deflateInit2(&stream, options.level, Z_DEFLATED, options.gzip ? 15 + 16 : 15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            throw std::runtime_error("failed to initialize zlib");
+    }
+
+    void deflate_input(int flush) {
+        stream.next_in = reinterpret_cast<Bytef*>(input.data());
+        stream.avail_in = static_cast<uInt>(input_end - input.data());
+        do {
+            stream.next_out = reinterpret_cast<Bytef*>(output.data());
+            stream.avail_out = static_cast<uInt>(output.size());
+            int result = deflate(&stream, flush);
+            if (result == Z_STREAM_ERROR)
+                throw std::runtime_error("zlib stream error");
+            write_output(output.data(), output.size() - stream.avail_out);
+        } while (stream.avail_out == 0);
+        input_end = input.data();
+    }
+
+    void write_output(const char* data, size_t size) {
+        if (file != nullptr) {
+            if (size != 0 && fwrite(data, size, 1, file) != 1)
+                throw std::runtime_error("failed to write compressed data");
+            if (options.flush == json_gzip_flush_record)
+                fflush(file);
+            return;
+        }
+        while (size != 0) {
+            ssize_t written = ::write(fd, data, size);
+            if (written < 0 && errno == EINTR)
+                continue;
+            if (written < 0)
+                throw std::runtime_error("failed to write compressed data");
+            data += written;
+            size -= written;
+        }
+    }
+
+    FILE* file;
+    int fd;
+    json_gzip_options options;
+    z_stream stream;
+    std::vector<char> input;
+    std::vector<char> output;
+    char* input_end;
+    bool closed = false;
+};
+
+inline void write_char(gzip_writer* writer, const char c) {
+    writer->write(c);
+}
+
+inline int write_string(gzip_writer* writer, const char* begin, const char* end) {
+    writer->write(begin, end);
+    return static_cast<int>(end - begin);
+}
+
+inline int write_string_unsafe(gzip_writer* writer, const char* text) {
+    return write_string(writer, text, text + strlen(text));
+}
+
+template <typename... T>
+int write_printf(gzip_writer* writer, const char* format, T&&... args) {
+    return writer->write_printf(format, std::forward<T>(args)...);
+}
+
+}
+
+/**
+ * Writer that compresses JSON text with deflate (in gzip or zlib format) while
+ * it's printed, writing the compressed data to a FILE* or a file descriptor.
+ * The stream is finished when the writer is closed or destroyed.
+ */
+using json_gzip_writer = detail::gzip_writer;
+
+/**
+ * Prints one record of JSON text into a compressed writer
+ */
+template <typename... Ts>
+inline void json_gzprint(json_gzip_writer& writer, const json_print_context& context, Ts&&... args) {
+    detail::json_print(&writer, context, std::forward<Ts>(args)...);
+    writer.end_record();
+}
+
+}
+
+#define json_gzprint_c(writer, format, ...) ([&](auto&&... jp_args){ constexpr auto x = JsonPrint::compile(format); JP_CHECK_SPREAD(x, jp_args); JsonPrint::json_gzprint(writer, x, std::forward<decltype(jp_args)>(jp_args)...); }(__VA_ARGS__))
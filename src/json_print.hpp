@@ -1,14 +1,22 @@
+#include <tuple>
+#include <type_traits>
 #include <utility>
 #include "json_print_compile.hpp"
 #include "json_print_arg_string.hpp"
 #include "json_print_arg_file.hpp"
 #include "json_print_arg.hpp"
+#include "json_print_static.hpp"
 
 namespace JsonPrint {
 namespace detail {
 
-template <typename Dest, size_t... Is, typename... Ts>
-inline void json_print(Dest dest, const json_print_context& context, std::index_sequence<Is...>, Ts&&... args) {
+template <typename T>
+struct non_deduced {
+    using type = T;
+};
+
+template <typename... Ts, typename Dest, size_t... Is>
+inline void json_print_indexed(Dest dest, const json_print_context& context, std::index_sequence<Is...>, const typename non_deduced<Ts>::type&... args) {
     // print the part of the format string before the first placeholder
     json_print_part(dest, context.parts[0], context.parts[1]);
 
@@ -20,20 +28,57 @@ inline void json_print(Dest dest, const json_print_context& context, std::index_
     //   1) prints the argument JSON-formatted, and then 
     //   2) prints the part of the format string after the placeholder
     std::initializer_list<bool> _ { (
-        json_print_arg(dest, args),
-        json_print_part(dest, context.parts[Is+1] + 1, context.parts[Is+2]),
+        json_print_spec_arg(dest, context.specs[Is], args),
+        json_print_part(dest, part_begin(context, Is+1), context.parts[Is+2]),
         false
     )... };
 }
 
 template <typename Dest, typename... Ts>
 inline void json_print(Dest dest, const json_print_context& context, Ts&&... args) {
-    // forward template arguments with index
-    detail::json_print(dest, context, std::index_sequence_for<Ts...> {}, std::forward<Ts>(args)...);
+    // forward template arguments with index, as their decayed types so that e.g. int&, 
+    // const int& and int, or string literals of different lengths share one instantiation
+    detail::json_print_indexed<typename std::decay<Ts>::type...>(dest, context, std::index_sequence_for<Ts...> {}, args...);
+}
+
+/**
+ * Compiled format string bound to its arguments, printed in place of a placeholder.
+ * The context is copied, so the argument can outlive a temporary context.
+ */
+template <typename... Ts>
+struct json_template_arg {
+    json_print_context context;
+    std::tuple<Ts...> args;
+};
+
+template <typename Dest, size_t... Is, typename... Ts>
+inline void json_print_template_arg(Dest dest, const json_template_arg<Ts...>& n, std::index_sequence<Is...>) {
+    json_print(dest, n.context, std::get<Is>(n.args)...);
+}
+
+template <typename Dest, typename... Ts>
+inline void json_print_arg(Dest dest, const json_template_arg<Ts...>& n) {
+    json_print_template_arg(dest, n, std::index_sequence_for<Ts...> {});
 }
 
 }
 
+/**
+ * Binds a compiled format string to its arguments, so that it can be used
+ * as the argument for a placeholder of another format string. Lvalue arguments
+ * are referenced, rvalue arguments are moved into the result.
+ */
+template <typename... Ts>
+inline detail::json_template_arg<Ts...> json_template(const json_print_context& context, Ts&&... args) {
+    return { context, std::tuple<Ts...>(std::forward<Ts>(args)...) };
+}
+
+// Compact mode changes what the printing functions compile to, so they are declared in 
+// an inline namespace named after the mode, and each translation unit can pick its own.
+// The compact versions are declared by json_print_compact.hpp.
+#ifndef JP_COMPACT
+inline namespace inlined {
+
 template <typename... Ts>
 inline void json_print(const json_print_context& context, Ts&&... args) {
     // forward template arguments with index
@@ -48,14 +93,35 @@ inline void json_fprint(FILE* file, const json_print_context& context, Ts&&... a
 
 template <typename... Ts>
 inline void json_sprint(char* buffer, size_t size, const json_print_context& context, Ts&&... args) {
-    // simulate stream with fat pointer
-    detail::string_buffer sbuffer = { buffer, buffer + size };
+    if (size == 0)
+        return;
+    // simulate stream with fat pointer, leaving room for the null terminator
+    detail::string_buffer sbuffer = { buffer, buffer + size - 1 };
     // forward template arguments with index
     detail::json_print(&sbuffer, context, std::forward<Ts>(args)...);
+    *sbuffer.begin = '\0';
+}
+
 }
+#endif
 
 }
 
-#define json_print_c(format, ...) ([&](){ constexpr auto x = JsonPrint::compile(format); JsonPrint::json_fprint(stdout, x, __VA_ARGS__); }())
-#define json_fprint_c(file, format, ...) ([&](){ constexpr auto x = JsonPrint::compile(format); JsonPrint::json_fprint(file, x, __VA_ARGS__); }())
-#define json_sprint_c(buffer, size, format, ...) ([&](){ constexpr auto x = JsonPrint::compile(format); JsonPrint::json_sprint(buffer, size, x, __VA_ARGS__); }())
+// rejects arguments that can't be spread into a "...?" placeholder of the format string
+#define JP_CHECK_SPREAD(x, args) static_assert(JsonPrint::detail::spreads_match<decltype(args)...>(x), "expected a map or a range of pairs with string keys for '...?'")
+
+#ifdef JP_STATS
+#define json_print_c(format, ...) ([&](auto&&... jp_args){ constexpr auto x = JsonPrint::compile(format); JP_CHECK_SPREAD(x, jp_args); static JsonPrint::json_print_site_stats site(__FILE__, __LINE__, format); JsonPrint::detail::json_print_measured(site, stdout, x, std::forward<decltype(jp_args)>(jp_args)...); }(__VA_ARGS__))
+#define json_fprint_c(file, format, ...) ([&](auto&&... jp_args){ constexpr auto x = JsonPrint::compile(format); JP_CHECK_SPREAD(x, jp_args); static JsonPrint::json_print_site_stats site(__FILE__, __LINE__, format); JsonPrint::detail::json_print_measured(site, file, x, std::forward<decltype(jp_args)>(jp_args)...); }(__VA_ARGS__))
+#define json_sprint_c(buffer, size, format, ...) ([&](auto&&... jp_args){ constexpr auto x = JsonPrint::compile(format); JP_CHECK_SPREAD(x, jp_args); static JsonPrint::json_print_site_stats site(__FILE__, __LINE__, format); JsonPrint::detail::json_sprint_measured(site, buffer, size, x, std::forward<decltype(jp_args)>(jp_args)...); }(__VA_ARGS__))
+#elif defined(JP_COMPACT)
+// the compact printer reads the context from memory, so it's stored once instead of built on each call
+#define json_print_c(format, ...) ([&](auto&&... jp_args){ static constexpr auto x = JsonPrint::compile(format); JP_CHECK_SPREAD(x, jp_args); JsonPrint::json_fprint(stdout, x, std::forward<decltype(jp_args)>(jp_args)...); }(__VA_ARGS__))
+#define json_fprint_c(file, format, ...) ([&](auto&&... jp_args){ static constexpr auto x = JsonPrint::compile(format); JP_CHECK_SPREAD(x, jp_args); JsonPrint::json_fprint(file, x, std::forward<decltype(jp_args)>(jp_args)...); }(__VA_ARGS__))
+#define json_sprint_c(buffer, size, format, ...) ([&](auto&&... jp_args){ static constexpr auto x = JsonPrint::compile(format); JP_CHECK_SPREAD(x, jp_args); JsonPrint::json_sprint(buffer, size, x, std::forward<decltype(jp_args)>(jp_args)...); }(__VA_ARGS__))
+#else
+#define json_print_c(format, ...) ([&](auto&&... jp_args){ constexpr auto x = JsonPrint::compile(format); JP_CHECK_SPREAD(x, jp_args); JsonPrint::json_fprint(stdout, x, std::forward<decltype(jp_args)>(jp_args)...); }(__VA_ARGS__))
+#define json_fprint_c(file, format, ...) ([&](auto&&... jp_args){ constexpr auto x = JsonPrint::compile(format); JP_CHECK_SPREAD(x, jp_args); JsonPrint::json_fprint(file, x, std::forward<decltype(jp_args)>(jp_args)...); }(__VA_ARGS__))
+#define json_sprint_c(buffer, size, format, ...) ([&](auto&&... jp_args){ constexpr auto x = JsonPrint::compile(format); JP_CHECK_SPREAD(x, jp_args); JsonPrint::json_sprint(buffer, size, x, std::forward<decltype(jp_args)>(jp_args)...); }(__VA_ARGS__))
+#endif
+#define json_template_c(format, ...) ([&](auto&&... jp_args){ static constexpr auto x = JsonPrint::compile(format); JP_CHECK_SPREAD(x, jp_args); return JsonPrint::json_template(x, std::forward<decltype(jp_args)>(jp_args)...); }(__VA_ARGS__))
@@ -1,29 +1,181 @@
+#include <cmath>
+#include <cstdint>
 #include <cstdio>
+#include <stdexcept>
+#include <string.h>
+#include <type_traits>
+#include <utility>
 #include <string>
 #include <map>
 #include <unordered_map>
 #include <vector>
 #include <array>
 
+/* 
+ * UTF-8 handling of string arguments. JP_UTF8_POLICY and JP_ASCII_ONLY change the
+ * inline functions that print strings, so they must have the same value in every
+ * file of a program, or the linker keeps one of the versions for all of them. Use
+ * json_string<Policy, AsciiOnly> for arguments that need a different policy.
+ */
+#define JP_UTF8_PASSTHROUGH 0 /* copy bytes of 128 and above unchecked */
+#define JP_UTF8_REPLACE 1     /* replace invalid UTF-8 with U+FFFD */
+#define JP_UTF8_ESCAPE 2      /* escape each invalid byte as \u00XX */
+#define JP_UTF8_REJECT 3      /* throw std::runtime_error on invalid UTF-8 */
+
+#ifndef JP_UTF8_POLICY
+#define JP_UTF8_POLICY JP_UTF8_PASSTHROUGH
+#endif
+
+/* When non-zero, non-ASCII characters are printed as \uXXXX escapes */
+#ifndef JP_ASCII_ONLY
+#define JP_ASCII_ONLY 0
+#endif
+
 namespace JsonPrint {
 namespace detail {
 
+template <bool CheckUtf8 = false>
 inline bool is_special_character(const char c) {
-    return c < 32 || c == '\\' || c == '\"';
+    const unsigned char u = static_cast<unsigned char>(c);
+    return u < 32 || c == '\\' || c == '\"' || (CheckUtf8 && u >= 0x80);
+}
+
+/**
+ * Finds the first character that can't be copied into a JSON string as-is,
+ * including non-ASCII characters if CheckUtf8 is set. Checks 8 characters at 
+ * a time with word-sized bit operations before falling back to one character 
+ * at a time.
+ */
+template <bool CheckUtf8>
+inline const char* find_special_character(const char* begin, const char* end) {
+    const uint64_t ones = ~uint64_t(0) / 255;
+    const uint64_t highs = ones * 0x80;
+    for (; end - begin >= 8; begin += 8) {
+        uint64_t word;
+        memcpy(&word, begin, sizeof(word));
+        uint64_t quotes = word ^ (ones * '"');
+        uint64_t backslashes = word ^ (ones * '\\');
+        uint64_t special = 
+            ((word - ones * 32) & ~word) |               // bytes below 32
+            ((quotes - ones) & ~quotes) |                // '"' bytes
+            ((backslashes - ones) & ~backslashes) |      // '\' bytes
+            (CheckUtf8 ? word : 0);                      // bytes of 128 and above
+        if (special & highs)
+            break;
+    }
+    for (; begin != end && !is_special_character<CheckUtf8>(*begin); begin++) {}
+    return begin;
+}
+
+/**
+ * Decodes the UTF-8 sequence starting at begin, and returns its length.
+ * If the sequence is invalid, codepoint is set to -1 and the length of 
+ * the invalid part is returned.
+ */
+inline size_t decode_utf8(const char* begin, const char* end, long& codepoint) {
+    const unsigned char lead = static_cast<unsigned char>(*begin);
+    size_t length = 0;
+    unsigned char min = 0x80;
+    unsigned char max = 0xBF;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        length = 2;
+        codepoint = lead & 0x1F;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        length = 3;
+        codepoint = lead & 0x0F;
+        min = lead == 0xE0 ? 0xA0 : min; // overlong
+        max = lead == 0xED ? 0x9F : max; // surrogates
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        length = 4;
+        codepoint = lead & 0x07;
+        min = lead == 0xF0 ? 0x90 : min; // overlong
+        max = lead == 0xF4 ? 0x8F : max; // above U+10FFFF
+    } else {
+        codepoint = -1;
+        return 1;
+    }
+
+    for (size_t i = 1; i < length; i++) {
+        // a truncated sequence at the end isn't read past the end
+        if (begin + i == end) {
+            codepoint = -1;
+            return i;
+        }
+        const unsigned char c = static_cast<unsigned char>(begin[i]);
+        if (c < min || c > max) {
+            codepoint = -1;
+            return i;
+        }
+        codepoint = (codepoint << 6) | (c & 0x3F);
+        min = 0x80;
+        max = 0xBF;
+    }
+    return length;
 }
 
 template <typename Dest>
-void json_print_string(Dest dest, const char* begin, const char* end) {
-    write_char(dest, '"');
-    for (; begin != end; begin++) {
-        const char* c;
-        for (c = begin; c != end && !is_special_character(*c); c++) {};
+inline void json_print_unicode_escape(Dest dest, unsigned long codepoint) {
+    const char* digits = "0123456789abcdef";
+    if (codepoint > 0xFFFF) {
+        // encode as a surrogate pair
+        codepoint -= 0x10000;
+        json_print_unicode_escape(dest, 0xD800 + (codepoint >> 10));
+        json_print_unicode_escape(dest, 0xDC00 + (codepoint & 0x3FF));
+        return;
+    }
+    const char text[6] = { '\\', 'u', 
+        digits[(codepoint >> 12) & 0xF], digits[(codepoint >> 8) & 0xF], 
+        digits[(codepoint >> 4) & 0xF], digits[codepoint & 0xF] };
+    write_string(dest, text, text + sizeof(text));
+}
+
+/**
+ * Prints the non-ASCII UTF-8 sequence starting at begin according to 
+ * the UTF-8 policy, and returns the end of the sequence
+ */
+template <int Utf8Policy, bool AsciiOnly, typename Dest>
+inline const char* json_print_utf8(Dest dest, const char* begin, const char* end) {
+    long codepoint = -1;
+    size_t length = decode_utf8(begin, end, codepoint);
+    if (codepoint < 0) {
+        switch (Utf8Policy) {
+            case JP_UTF8_REPLACE:
+                if (AsciiOnly)
+                    json_print_unicode_escape(dest, 0xFFFD);
+                else
+                    write_string_unsafe(dest, "\xEF\xBF\xBD");
+                return begin + length;
+            case JP_UTF8_REJECT:
+                throw std::runtime_error("invalid UTF-8 in string");
+            default:
+                break;
+        }
+    }
+    
+    if (AsciiOnly && codepoint >= 0) {
+        json_print_unicode_escape(dest, codepoint);
+    } else if (codepoint < 0 && (AsciiOnly || Utf8Policy == JP_UTF8_ESCAPE)) {
+        // escape each invalid byte as the code point of the same value
+        for (const char* c = begin; c != begin + length; c++)
+            json_print_unicode_escape(dest, static_cast<unsigned char>(*c));
+    } else {
+        write_string(dest, begin, begin + length);
+    }
+    return begin + length;
+}
+
+/**
+ * Prints the characters of a JSON string, escaped but without the quotes
+ */
+template <int Utf8Policy = JP_UTF8_POLICY, bool AsciiOnly = JP_ASCII_ONLY, typename Dest>
+void json_print_escaped(Dest dest, const char* begin, const char* end) {
+    constexpr bool check_utf8 = Utf8Policy != JP_UTF8_PASSTHROUGH || AsciiOnly;
+    while (begin != end) {
+        const char* c = find_special_character<check_utf8>(begin, end);
         write_string(dest, begin, c);
 
         if (c == end)
             break;
-        if (c == end - 1 && *c == '\0')
-            break;
 
         switch(*c) {
             case '"':
@@ -48,12 +200,29 @@ void json_print_string(Dest dest, const char* begin, const char* end) {
                 write_string_unsafe(dest, R"(\t)");
                 break;
             default:
-                write_printf(dest, "\\%04u", static_cast<unsigned>(*c));
+                if (static_cast<unsigned char>(*c) >= 0x80) {
+                    begin = json_print_utf8<Utf8Policy, AsciiOnly>(dest, c, end);
+                    continue;
+                }
+                json_print_unicode_escape(dest, static_cast<unsigned char>(*c));
                 break;
         }
 
-        begin = c;
+        begin = c + 1;
     }
+}
+
+/**
+ * Prints a JSON string. The UTF-8 policy and ASCII-only mode default to the
+ * JP_UTF8_POLICY and JP_ASCII_ONLY configuration
+ */
+template <int Utf8Policy = JP_UTF8_POLICY, bool AsciiOnly = JP_ASCII_ONLY, typename Dest>
+void json_print_string(Dest dest, const char* begin, const char* end) {
+    // a trailing null terminator isn't printed
+    if (begin != end && *(end - 1) == '\0')
+        end--;
+    write_char(dest, '"');
+    json_print_escaped<Utf8Policy, AsciiOnly>(dest, begin, end);
     write_char(dest, '"');
 }
 
@@ -161,18 +330,60 @@ inline void json_print_arg(Dest dest, long double n) {
     json_print_float_arg(dest, n); 
 }
 
+/**
+ * String printed with a UTF-8 policy and ASCII-only mode of its own, rather than
+ * the JP_UTF8_POLICY and JP_ASCII_ONLY configuration
+ */
+template <int Utf8Policy, bool AsciiOnly>
+struct json_string_arg {
+    const char* begin;
+    const char* end;
+};
+
+template <typename Dest, int Utf8Policy, bool AsciiOnly>
+inline void json_print_arg(Dest dest, const json_string_arg<Utf8Policy, AsciiOnly>& n) {
+    json_print_string<Utf8Policy, AsciiOnly>(dest, n.begin, n.end);
+}
+
+/* elements */
+
+template <typename Dest, typename T>
+inline void json_print_spec_arg(Dest dest, const json_print_spec& spec, const T& n);
+
+/**
+ * Prints an element of a container or generator through json_print_spec_arg, so that
+ * the overloads of the optional headers, which are declared next to json_print_spec,
+ * are found for any sink
+ */
+template <typename Dest, typename T>
+inline void json_print_element(Dest dest, const T& n) {
+    json_print_spec_arg(dest, json_print_spec {}, n);
+}
+
+/* pair types */
+
+/** Pair printed as a JSON array of two elements, such as the members of a map */
+template <typename Dest, typename K, typename V>
+inline void json_print_arg(Dest dest, const std::pair<K, V>& n) {
+    write_char(dest, '[');
+    json_print_element(dest, n.first);
+    write_char(dest, ',');
+    json_print_element(dest, n.second);
+    write_char(dest, ']');
+}
+
 /* array types */
 
 template <typename Dest, typename T>
-inline void json_print_array_arg(Dest dest, T n) {
+inline void json_print_array_arg(Dest dest, const T& n) {
     write_char(dest, '[');
     auto it = n.begin();
     if (it != n.end()) {
-        json_print_arg(dest, *it++);
+        json_print_element(dest, *it++);
     }
     while (it != n.end()) {
         write_char(dest, ',');
-        json_print_arg(dest, *it++);
+        json_print_element(dest, *it++);
     }
     write_char(dest, ']');
 }
@@ -187,24 +398,96 @@ inline void json_print_arg(Dest dest, const std::array<T, N>& n) {
     json_print_array_arg(dest, n);
 }
 
+/* lazy array types */
+
+/**
+ * Iterator pair printed as a JSON array, elements are read while printing
+ */
+template <typename It>
+struct json_range_arg {
+    It first;
+    It last;
+
+    It begin() const { return first; }
+    It end() const { return last; }
+};
+
+/**
+ * Callable printed as a JSON array. It is invoked once with an "emit"
+ * callable, and each value passed to "emit" is printed as an element.
+ */
+template <typename F>
+struct json_generator_arg {
+    mutable F generate;
+};
+
+template <typename Dest, typename It>
+inline void json_print_arg(Dest dest, const json_range_arg<It>& n) {
+    json_print_array_arg(dest, n);
+}
+
+template <typename Dest, typename F>
+inline void json_print_arg(Dest dest, const json_generator_arg<F>& n) {
+    bool first = true;
+    write_char(dest, '[');
+    n.generate([&](const auto& item) {
+        if (!first)
+            write_char(dest, ',');
+        first = false;
+        json_print_element(dest, item);
+    });
+    write_char(dest, ']');
+}
+
+/* raw JSON */
+
+/**
+ * JSON text that has already been serialized, printed as it is
+ */
+struct json_raw_arg {
+    const char* begin;
+    const char* end;
+    bool validated = false; // set by json_raw_validated, so converters don't check it again
+};
+
+template <typename Dest>
+inline void json_print_arg(Dest dest, const json_raw_arg& n) {
+    write_string(dest, n.begin, n.end);
+}
+
+/**
+ * Validates the structure of raw JSON text with the format string parser, which
+ * doesn't decode strings or numbers
+ */
+inline void validate_raw(const char* begin, const char* end) {
+    json_print_context context = { 0 };
+    if (skip_whitespace(begin, end) == end)
+        throw std::runtime_error("expected value, reached end of text");
+    begin = parse_value(begin, end, context);
+    if (context.count != 0)
+        throw std::runtime_error("unexpected placeholder in raw JSON");
+    if (skip_whitespace(begin, end) != end)
+        throw std::runtime_error("expected end of text, reached additional content");
+}
+
 /* object types */
 
 template <typename Dest, typename T>
-inline void json_print_object_arg(Dest dest, T n)
+inline void json_print_object_arg(Dest dest, const T& n)
 {
     write_char(dest, '{');
     auto it = n.begin();
     if (it != n.end()) {
         json_print_arg(dest, it->first);
         write_char(dest, ':');
-        json_print_arg(dest, it->second);
+        json_print_element(dest, it->second);
         it++;
     }
     while (it != n.end()) {
         write_char(dest, ',');
         json_print_arg(dest, it->first);
         write_char(dest, ':');
-        json_print_arg(dest, it->second);
+        json_print_element(dest, it->second);
         it++;
     }
     write_char(dest, '}');
@@ -250,11 +533,225 @@ inline void json_print_arg(Dest dest, const std::unordered_map<std::string_view,
 }
 #endif
 
+/* placeholder specifiers */
+
+/** Whether a specifier applies to arguments of type T */
+template <typename T>
+using is_spec_number = std::integral_constant<bool,
+    std::is_arithmetic<T>::value && !std::is_same<T, bool>::value && !std::is_same<T, char>::value>;
+
+template <typename Dest, typename T>
+inline void json_print_hex_arg(Dest dest, char type, T n, std::true_type) {
+    // negative numbers are printed as their two's complement, like printf
+    unsigned long long bits = static_cast<typename std::make_unsigned<T>::type>(n);
+    write_printf(dest, type == 'x' ? "\"%llx\"" : "\"%llX\"", bits);
+}
+
+template <typename Dest, typename T>
+inline void json_print_hex_arg(Dest dest, char, T n, std::false_type) {
+    json_print_arg(dest, n);
+}
+
+template <typename Dest, typename T>
+inline void json_print_spec_number(Dest dest, const json_print_spec& spec, T n) {
+    if (spec.type == 'x' || spec.type == 'X') {
+        json_print_hex_arg(dest, spec.type, n, std::is_integral<T> {});
+        return;
+    }
+    double value = static_cast<double>(n);
+    if (std::isnan(value) || std::isinf(value))
+        json_print_arg(dest, nullptr);
+    else if (spec.type == 'f')
+        write_printf(dest, "%.*f", spec.precision == -1 ? 6 : spec.precision, value);
+    else if (spec.type == 'e')
+        write_printf(dest, "%.*e", spec.precision == -1 ? 6 : spec.precision, value);
+    else
+        write_printf(dest, "%.*g", spec.precision == -1 ? 6 : spec.precision, value);
+}
+
+template <typename Dest, typename T>
+inline void json_print_spec_arg(Dest dest, const json_print_spec& spec, const T& n, std::true_type) {
+    if (spec.type == 0 || spec.type == 'm')
+        json_print_arg(dest, n);
+    else
+        json_print_spec_number(dest, spec, n);
+}
+
+template <typename Dest, typename T>
+inline void json_print_spec_arg(Dest dest, const json_print_spec&, const T& n, std::false_type) {
+    // specifiers only apply to numbers
+    json_print_arg(dest, n);
+}
+
+/* spread placeholders */
+
+/** Whether K can be printed as a member name, like the keys of map arguments */
+template <typename K>
+struct is_string_key : std::integral_constant<bool, 
+    std::is_same<K, const char*>::value || std::is_same<K, char*>::value || std::is_same<K, std::string>::value> {};
+
+#ifdef __cpp_lib_string_view
+template <>
+struct is_string_key<std::string_view> : std::true_type {};
+#endif
+
+/** Whether T holds key-value pairs with string keys, like a map or a range of pairs */
+template <typename T, typename = void>
+struct is_spreadable : std::false_type {};
+
+template <typename T>
+struct is_spreadable<T, decltype(void(std::declval<const T&>().begin()->second))> 
+    : is_string_key<typename std::decay<decltype(std::declval<const T&>().begin()->first)>::type> {};
+
+template <typename Dest, typename T>
+inline void json_print_spread_arg(Dest dest, const json_print_spec& spec, const T& n, std::true_type) {
+    // members are printed like those of a map, with the ',' taken from the format string
+    bool first = true;
+    for (const auto& member : n) {
+        if (!first || spec.precision == spread_comma_before)
+            write_char(dest, ',');
+        first = false;
+        json_print_arg(dest, member.first);
+        write_char(dest, ':');
+        json_print_element(dest, member.second);
+    }
+    if (!first && spec.precision == spread_comma_after)
+        write_char(dest, ',');
+}
+
+template <typename Dest, typename T>
+inline void json_print_spread_arg(Dest, const json_print_spec&, const T&, std::false_type) {
+    // only reached when the format string isn't a constant, otherwise spreads_match rejects it
+    throw std::runtime_error("expected a map or a range of pairs with string keys for '...?'");
+}
+
+/**
+ * Whether every spread placeholder of a format string has an argument that can be
+ * spread. Printing macros and the C++20 API check this at compile-time.
+ */
+template <typename... Ts>
+constexpr bool spreads_match(const json_print_context& context) {
+    // leading element, so the array isn't empty without arguments
+    constexpr bool spreadable[] = { true, is_spreadable<typename std::decay<Ts>::type>::value... };
+    for (size_t i = 0; i < sizeof...(Ts) && i + 1 < context.count; i++) {
+        if (context.specs[i].type == 's' && !spreadable[i + 1])
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Prints a placeholder argument with its specifier. The specifier of a compiled
+ * format string is a constant, so the branches are resolved when inlined.
+ */
+template <typename Dest, typename T>
+inline void json_print_spec_arg(Dest dest, const json_print_spec& spec, const T& n) {
+    if (spec.type == 's')
+        json_print_spread_arg(dest, spec, n, is_spreadable<T> {});
+    else
+        json_print_spec_arg(dest, spec, n, is_spec_number<T> {});
+}
+
 template <typename Dest>
 inline void json_print_part(Dest dest, const char* begin, const char* end) {
+    // format strings compiled with their null terminator end with '\0', which isn't printed
+    if (begin != end && *(end - 1) == '\0')
+        end--;
     write_string(dest, begin, end);
 }
 
 }
 
+/**
+ * Wraps an iterator pair as a placeholder argument, printed as a JSON array 
+ * without copying the elements into a container first
+ */
+template <typename It>
+inline detail::json_range_arg<It> json_range(It first, It last) {
+    return { first, last };
+}
+
+/**
+ * Wraps a generator as a placeholder argument, printed as a JSON array.
+ * The generator is called with an "emit" callable, and produces elements 
+ * on demand by calling it once per element.
+ */
+template <typename F>
+inline detail::json_generator_arg<F> json_generator(F generate) {
+    return { std::move(generate) };
+}
+
+/**
+ * Wraps a string as a placeholder argument, printed with the given UTF-8 policy and
+ * ASCII-only mode instead of the JP_UTF8_POLICY and JP_ASCII_ONLY configuration. 
+ * The text isn't copied.
+ */
+template <int Utf8Policy, bool AsciiOnly = false>
+inline detail::json_string_arg<Utf8Policy, AsciiOnly> json_string(const char* begin, const char* end) {
+    return { begin, end };
+}
+
+template <int Utf8Policy, bool AsciiOnly = false>
+inline detail::json_string_arg<Utf8Policy, AsciiOnly> json_string(const char* text) {
+    return { text, text + strlen(text) };
+}
+
+template <int Utf8Policy, bool AsciiOnly = false>
+inline detail::json_string_arg<Utf8Policy, AsciiOnly> json_string(const std::string& text) {
+    return { text.data(), text.data() + text.size() };
+}
+
+#ifdef __cpp_lib_string_view
+template <int Utf8Policy, bool AsciiOnly = false>
+inline detail::json_string_arg<Utf8Policy, AsciiOnly> json_string(std::string_view text) {
+    return { text.data(), text.data() + text.size() };
+}
+#endif
+
+/**
+ * Wraps JSON text that has already been serialized as a placeholder argument, 
+ * copied into the output as it is with a single write. The text isn't validated,
+ * and must stay valid until it's printed.
+ */
+inline detail::json_raw_arg json_raw(const char* begin, const char* end) {
+    return { begin, end };
+}
+
+inline detail::json_raw_arg json_raw(const char* text) {
+    return { text, text + strlen(text) };
+}
+
+inline detail::json_raw_arg json_raw(const std::string& text) {
+    return { text.data(), text.data() + text.size() };
+}
+
+#ifdef __cpp_lib_string_view
+inline detail::json_raw_arg json_raw(std::string_view text) {
+    return { text.data(), text.data() + text.size() };
+}
+#endif
+
+/**
+ * Like json_raw, but first checks that the text is a single valid JSON value
+ * @throws std::runtime_error if the text isn't valid JSON
+ */
+inline detail::json_raw_arg json_raw_validated(const char* begin, const char* end) {
+    detail::validate_raw(begin, end);
+    return { begin, end, true };
+}
+
+inline detail::json_raw_arg json_raw_validated(const char* text) {
+    return json_raw_validated(text, text + strlen(text));
+}
+
+inline detail::json_raw_arg json_raw_validated(const std::string& text) {
+    return json_raw_validated(text.data(), text.data() + text.size());
+}
+
+#ifdef __cpp_lib_string_view
+inline detail::json_raw_arg json_raw_validated(std::string_view text) {
+    return json_raw_validated(text.data(), text.data() + text.size());
+}
+#endif
+
 }
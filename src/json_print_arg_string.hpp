@@ -6,10 +6,35 @@
 #include <vector>
 #include <array>
 #include <algorithm>
+#include <memory>
 
 namespace JsonPrint {
 namespace detail {
 
+/** Size of the stack buffer that sinks format numbers into with snprintf */
+constexpr int printf_buffer_size = 128;
+
+/**
+ * Formats text with snprintf and passes it to write, as (begin, end). The text is
+ * formatted on the stack, or on the heap if it's longer, like "%.99f" of a large
+ * number. Returns the length of the text, or 0 if snprintf failed.
+ */
+template <typename Write, typename... T>
+inline int format_printf(Write write, const char* format, const T&... args) {
+    char text[printf_buffer_size];
+    int result = snprintf(text, sizeof(text), format, args...);
+    if (result <= 0)
+        return 0;
+    if (result < printf_buffer_size) {
+        write(text, text + result);
+        return result;
+    }
+    std::unique_ptr<char[]> long_text(new char[result + 1]);
+    snprintf(long_text.get(), result + 1, format, args...);
+    write(long_text.get(), long_text.get() + result);
+    return result;
+}
+
 struct string_buffer {
     char* begin;
     char* end;
@@ -34,10 +59,44 @@ inline int write_string_unsafe(string_buffer* buffer, const char* text) {
 template <typename... T>
 int write_printf(string_buffer* buffer, const char* format, T&&... args)
 {
-    int result = (std::min)(
-        snprintf(buffer->begin, buffer->end - buffer->begin, format, std::forward<T>(args)...), 
-        static_cast<int>(buffer->end - buffer->begin));
-    buffer->begin += result;
+    int available = static_cast<int>(buffer->end - buffer->begin);
+    int result = snprintf(buffer->begin, available, format, args...);
+    if (result < available) {
+        buffer->begin += (std::max)(result, 0);
+        return result;
+    }
+
+    // snprintf reserves the last byte for its terminator, so format on the side and copy what fits
+    return format_printf([buffer](const char* text, const char* text_end) { write_string(buffer, text, text_end); }, format, args...);
+}
+
+/* growable string buffer */
+
+inline void write_char(std::string* buffer, const char c) {
+    buffer->push_back(c);
+}
+
+inline int write_string(std::string* buffer, const char* begin, const char* end) {
+    buffer->append(begin, end);
+    return static_cast<int>(end - begin);
+}
+
+inline int write_string_unsafe(std::string* buffer, const char* text) {
+    return write_string(buffer, text, text + strlen(text));
+}
+
+template <typename... T>
+int write_printf(std::string* buffer, const char* format, T&&... args)
+{
+    char text[128];
+    int result = snprintf(text, sizeof(text), format, args...);
+    if (result < static_cast<int>(sizeof(text)))
+        return write_string(buffer, text, text + (std::max)(result, 0));
+
+    size_t size = buffer->size();
+    buffer->resize(size + result + 1);
+    snprintf(&(*buffer)[size], result + 1, format, args...);
+    buffer->resize(size + result);
     return result;
 }
 
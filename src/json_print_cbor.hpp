@@ -0,0 +1,477 @@
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <initializer_list>
+#include <map>
+#include <stdexcept>
+#include <stdlib.h>
+#include <string>
+#include <string.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/*
+ * Optional CBOR output from compiled templates. Include after json_print.hpp.
+ */
+
+namespace JsonPrint {
+
+/**
+ * Compiled format string encoded as CBOR (RFC 8949). The literal parts are
+ * encoded once, and each placeholder is a slot between them that is filled
+ * with a CBOR-encoded argument.
+ */
+struct json_cbor_template {
+    /** Encoded literal parts, one more than the number of placeholders */
+    std::vector<std::string> parts;
+};
+
+namespace detail {
+
+enum cbor_major_type : unsigned char {
+    cbor_unsigned = 0,
+    cbor_negative = 1,
+    cbor_text = 3,
+    cbor_array = 4,
+    cbor_map = 5,
+    cbor_simple = 7
+};
+
+const unsigned char cbor_false = 0xF4;
+const unsigned char cbor_true = 0xF5;
+const unsigned char cbor_null = 0xF6;
+const unsigned char cbor_float64 = 0xFB;
+const unsigned char cbor_indefinite_array = 0x9F;
+const unsigned char cbor_break = 0xFF;
+
+/** Writes a big-endian integer of N bytes */
+template <size_t N, typename Dest>
+inline void write_cbor_bytes(Dest dest, uint64_t value) {
+    char bytes[N];
+    for (size_t i = 0; i < N; i++)
+        bytes[i] = static_cast<char>(value >> (8 * (N - 1 - i)));
+    write_string(dest, bytes, bytes + N);
+}
+
+/** Writes the initial byte of a data item, and its argument in as few bytes as possible */
+template <typename Dest>
+inline void write_cbor_head(Dest dest, cbor_major_type type, uint64_t value) {
+    const char major = static_cast<char>(type << 5);
+    if (value < 24) {
+        write_char(dest, major | static_cast<char>(value));
+    } else if (value <= 0xFF) {
+        write_char(dest, major | 24);
+        write_cbor_bytes<1>(dest, value);
+    } else if (value <= 0xFFFF) {
+        write_char(dest, major | 25);
+        write_cbor_bytes<2>(dest, value);
+    } else if (value <= 0xFFFFFFFF) {
+        write_char(dest, major | 26);
+        write_cbor_bytes<4>(dest, value);
+    } else {
+        write_char(dest, major | 27);
+        write_cbor_bytes<8>(dest, value);
+    }
+}
+
+template <typename Dest>
+inline void cbor_print_signed(Dest dest, long long n) {
+    if (n < 0)
+        write_cbor_head(dest, cbor_negative, static_cast<uint64_t>(-(n + 1)));
+    else
+        write_cbor_head(dest, cbor_unsigned, static_cast<uint64_t>(n));
+}
+
+template <typename Dest>
+inline void cbor_print_double(Dest dest, double n) {
+    uint64_t bits;
+    memcpy(&bits, &n, sizeof(bits));
+    write_char(dest, static_cast<char>(cbor_float64));
+    write_cbor_bytes<8>(dest, bits);
+}
+
+template <typename Dest>
+inline void cbor_print_text(Dest dest, const char* begin, const char* end) {
+    write_cbor_head(dest, cbor_text, end - begin);
+    write_string(dest, begin, end);
+}
+
+/* string types */
+
+template <typename Dest>
+inline void cbor_print_arg(Dest dest, const std::string& arg) {
+    cbor_print_text(dest, arg.data(), arg.data() + arg.size());
+}
+
+#ifdef __cpp_lib_string_view
+template <typename Dest>
+inline void cbor_print_arg(Dest dest, std::string_view arg) {
+    cbor_print_text(dest, arg.data(), arg.data() + arg.size());
+}
+#endif
+
+template <typename Dest>
+inline void cbor_print_arg(Dest dest, const char* arg) {
+    cbor_print_text(dest, arg, arg + strlen(arg));
+}
+
+template <typename Dest, int Utf8Policy, bool AsciiOnly>
+inline void cbor_print_arg(Dest dest, const json_string_arg<Utf8Policy, AsciiOnly>& n) {
+    // CBOR text is copied as it is, like other strings
+    cbor_print_text(dest, n.begin, n.end);
+}
+
+template <typename Dest>
+inline void cbor_print_arg(Dest dest, const char n) {
+    cbor_print_text(dest, &n, &n + 1);
+}
+
+/* number types */
+
+template <typename Dest>
+inline void cbor_print_arg(Dest dest, bool b) {
+    write_char(dest, static_cast<char>(b ? cbor_true : cbor_false));
+}
+
+template <typename Dest>
+inline void cbor_print_arg(Dest dest, std::nullptr_t) {
+    write_char(dest, static_cast<char>(cbor_null));
+}
+
+template <typename Dest>
+inline void cbor_print_arg(Dest dest, unsigned char n) {
+    write_cbor_head(dest, cbor_unsigned, n);
+}
+
+template <typename Dest>
+inline void cbor_print_arg(Dest dest, short n) {
+    cbor_print_signed(dest, n);
+}
+
+template <typename Dest>
+inline void cbor_print_arg(Dest dest, unsigned short n) {
+    write_cbor_head(dest, cbor_unsigned, n);
+}
+
+template <typename Dest>
+inline void cbor_print_arg(Dest dest, int n) {
+    cbor_print_signed(dest, n);
+}
+
+template <typename Dest>
+inline void cbor_print_arg(Dest dest, unsigned n) {
+    write_cbor_head(dest, cbor_unsigned, n);
+}
+
+template <typename Dest>
+inline void cbor_print_arg(Dest dest, long n) {
+    cbor_print_signed(dest, n);
+}
+
+template <typename Dest>
+inline void cbor_print_arg(Dest dest, unsigned long n) {
+    write_cbor_head(dest, cbor_unsigned, n);
+}
+
+template <typename Dest>
+inline void cbor_print_arg(Dest dest, long long n) {
+    cbor_print_signed(dest, n);
+}
+
+template <typename Dest>
+inline void cbor_print_arg(Dest dest, unsigned long long n) {
+    write_cbor_head(dest, cbor_unsigned, n);
+}
+
+template <typename Dest>
+inline void cbor_print_arg(Dest dest, double n) {
+    // same as JSON output, where non-finite numbers are printed as null
+    if (std::isnan(n) || std::isinf(n))
+        cbor_print_arg(dest, nullptr);
+    else
+        cbor_print_double(dest, n);
+}
+
+template <typename Dest>
+inline void cbor_print_arg(Dest dest, float n) {
+    cbor_print_arg(dest, static_cast<double>(n));
+}
+
+template <typename Dest>
+inline void cbor_print_arg(Dest dest, long double n) {
+    cbor_print_arg(dest, static_cast<double>(n));
+}
+
+/* array types */
+
+template <typename Dest, typename T>
+inline void cbor_print_array_arg(Dest dest, const T& n, size_t size) {
+    write_cbor_head(dest, cbor_array, size);
+    for (const auto& item : n)
+        cbor_print_arg(dest, item);
+}
+
+template <typename Dest, typename T>
+inline void cbor_print_arg(Dest dest, const std::vector<T>& n) {
+    cbor_print_array_arg(dest, n, n.size());
+}
+
+template <typename Dest, typename T, size_t N>
+inline void cbor_print_arg(Dest dest, const std::array<T, N>& n) {
+    cbor_print_array_arg(dest, n, N);
+}
+
+/* lazy array types, whose length is unknown until they are printed */
+
+template <typename Dest, typename It>
+inline void cbor_print_arg(Dest dest, const json_range_arg<It>& n) {
+    write_char(dest, static_cast<char>(cbor_indefinite_array));
+    for (It it = n.begin(); it != n.end(); ++it)
+        cbor_print_arg(dest, *it);
+    write_char(dest, static_cast<char>(cbor_break));
+}
+
+template <typename Dest, typename F>
+inline void cbor_print_arg(Dest dest, const json_generator_arg<F>& n) {
+    write_char(dest, static_cast<char>(cbor_indefinite_array));
+    n.generate([&](const auto& item) {
+        cbor_print_arg(dest, item);
+    });
+    write_char(dest, static_cast<char>(cbor_break));
+}
+
+/* object types */
+
+template <typename Dest, typename T>
+inline void cbor_print_object_arg(Dest dest, const T& n) {
+    write_cbor_head(dest, cbor_map, n.size());
+    for (const auto& member : n) {
+        cbor_print_arg(dest, member.first);
+        cbor_print_arg(dest, member.second);
+    }
+}
+
+template <typename Dest, typename K, typename T>
+inline void cbor_print_arg(Dest dest, const std::map<K, T>& n) {
+    cbor_print_object_arg(dest, n);
+}
+
+template <typename Dest, typename K, typename T>
+inline void cbor_print_arg(Dest dest, const std::unordered_map<K, T>& n) {
+    cbor_print_object_arg(dest, n);
+}
+
+/**
+ * Literal part of a template being encoded, with the placeholders found so far
+ */
+struct cbor_fragment {
+    std::vector<std::string> parts { std::string() };
+
+    void append(const cbor_fragment& other) {
+        parts.back() += other.parts.front();
+        parts.insert(parts.end(), other.parts.begin() + 1, other.parts.end());
+    }
+};
+
+inline void write_char(cbor_fragment* fragment, const char c) {
+    fragment->parts.back().push_back(c);
+}
+
+inline int write_string(cbor_fragment* fragment, const char* begin, const char* end) {
+    fragment->parts.back().append(begin, end);
+    return static_cast<int>(end - begin);
+}
+
+inline void cbor_append_utf8(std::string& text, unsigned long codepoint) {
+    if (codepoint < 0x80) {
+        text += static_cast<char>(codepoint);
+    } else if (codepoint < 0x800) {
+        text += static_cast<char>(0xC0 | (codepoint >> 6));
+        text += static_cast<char>(0x80 | (codepoint & 0x3F));
+    } else if (codepoint < 0x10000) {
+        text += static_cast<char>(0xE0 | (codepoint >> 12));
+        text += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        text += static_cast<char>(0x80 | (codepoint & 0x3F));
+    } else {
+        text += static_cast<char>(0xF0 | (codepoint >> 18));
+        text += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+        text += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        text += static_cast<char>(0x80 | (codepoint & 0x3F));
+    }
+}
+
+/** Decodes a JSON string literal that has already been validated, returning the end of it */
+inline const char* cbor_decode_string(const char* begin, const char* end, std::string& text) {
+    begin++; // skip opening quote
+    while (begin != end && *begin != '"') {
+        if (*begin != '\\') {
+            text += *begin++;
+            continue;
+        }
+        begin++;
+        switch (*begin++) {
+            case 'b': text += '\b'; break;
+            case 'f': text += '\f'; break;
+            case 'n': text += '\n'; break;
+            case 'r': text += '\r'; break;
+            case 't': text += '\t'; break;
+            case 'u': {
+                unsigned long codepoint = strtoul(std::string(begin, begin + 4).c_str(), nullptr, 16);
+                begin += 4;
+                // combine surrogate pairs
+                if (codepoint >= 0xD800 && codepoint < 0xDC00 && begin[0] == '\\' && begin[1] == 'u') {
+                    unsigned long low = strtoul(std::string(begin + 2, begin + 6).c_str(), nullptr, 16);
+                    if (low >= 0xDC00 && low < 0xE000) {
+                        codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+                        begin += 6;
+                    }
+                }
+                cbor_append_utf8(text, codepoint);
+                break;
+            }
+            default: text += begin[-1]; break; // '"', '\' and '/'
+        }
+    }
+    return begin + 1;
+}
+
+/**
+ * Encodes the JSON value at begin, which has already been validated by compile,
+ * and returns the end of it. The text doesn't need to be null-terminated.
+ */
+inline const char* cbor_encode_value(const char* begin, const char* end, cbor_fragment& fragment) {
+    begin = skip_whitespace(begin, end);
+    switch (*begin) {
+        case '[':
+        case '{': {
+            const bool object = *begin == '{';
+            const char close = object ? '}' : ']';
+            cbor_fragment items;
+            size_t count = 0;
+            begin++;
+            while (true) {
+                while (is_whitespace(*begin) || *begin == ',')
+                    begin++;
+                if (*begin == close)
+                    break;
+                begin = cbor_encode_value(begin, end, items);
+                if (object) {
+                    // skip ':' and encode the member value
+                    while (is_whitespace(*begin) || *begin == ':')
+                        begin++;
+                    begin = cbor_encode_value(begin, end, items);
+                }
+                count++;
+            }
+            write_cbor_head(&fragment, object ? cbor_map : cbor_array, count);
+            fragment.append(items);
+            return begin + 1;
+        }
+
+        case '"': {
+            std::string text;
+            begin = cbor_decode_string(begin, end, text);
+            cbor_print_text(&fragment, text.data(), text.data() + text.size());
+            return begin;
+        }
+
+        case 't':
+            cbor_print_arg(&fragment, true);
+            return begin + 4;
+
+        case 'f':
+            cbor_print_arg(&fragment, false);
+            return begin + 5;
+
+        case 'n':
+            cbor_print_arg(&fragment, nullptr);
+            return begin + 4;
+
+        case '?':
+            // specifiers only apply to JSON text
+            fragment.parts.emplace_back();
+            return begin[1] == '{' ? std::find(begin, end, '}') + 1 : begin + 1;
+
+        default: {
+            const char* number_end = parse_number(begin, end);
+            bool integer = std::find_if(begin, number_end, [](char c) { return c == '.' || c == 'e' || c == 'E'; }) == number_end;
+            // strtoll and strtod need a null-terminated copy, which is usually short enough for SSO
+            std::string number(begin, number_end);
+            if (integer) {
+                errno = 0;
+                long long n = strtoll(number.c_str(), nullptr, 10);
+                if (errno == 0) {
+                    cbor_print_signed(&fragment, n);
+                    return number_end;
+                }
+            }
+            cbor_print_double(&fragment, strtod(number.c_str(), nullptr));
+            return number_end;
+        }
+    }
+}
+
+/**
+ * Raw JSON is converted, since it can't be copied into CBOR as it is. It's validated
+ * first unless json_raw_validated already did.
+ */
+template <typename Dest>
+inline void cbor_print_arg(Dest dest, const json_raw_arg& n) {
+    if (!n.validated)
+        validate_raw(n.begin, n.end);
+    cbor_fragment fragment;
+    cbor_encode_value(n.begin, n.end, fragment);
+    write_string(dest, fragment.parts[0].data(), fragment.parts[0].data() + fragment.parts[0].size());
+}
+
+template <typename Dest, size_t... Is, typename... Ts>
+inline void cbor_print(Dest dest, const json_cbor_template& format, std::index_sequence<Is...>, const Ts&... args) {
+    // same structure as json_print, with pre-encoded literal parts
+    write_string(dest, format.parts[0].data(), format.parts[0].data() + format.parts[0].size());
+    std::initializer_list<bool> _ { (
+        cbor_print_arg(dest, args),
+        write_string(dest, format.parts[Is + 1].data(), format.parts[Is + 1].data() + format.parts[Is + 1].size()),
+        false
+    )... };
+}
+
+}
+
+/**
+ * Encodes the literal parts of a compiled format string as CBOR, leaving a
+ * slot for each placeholder
+ */
+inline json_cbor_template compile_cbor(const json_print_context& context) {
+    for (size_t i = 0; i + 1 < context.count; i++) {
+        if (context.specs[i].type == 's')
+            throw std::runtime_error("'...?' is not supported in CBOR templates");
+    }
+    detail::cbor_fragment fragment;
+    detail::cbor_encode_value(context.parts[0], context.parts[context.count], fragment);
+    return { std::move(fragment.parts) };
+}
+
+/**
+ * Writes CBOR data to a file
+ */
+template <typename... Ts>
+inline void json_cbor_fprint(FILE* file, const json_cbor_template& format, const Ts&... args) {
+    detail::cbor_print(file, format, std::index_sequence_for<Ts...> {}, args...);
+}
+
+/**
+ * Writes CBOR data to a buffer, and returns the number of bytes written. The data is
+ * truncated if it doesn't fit.
+ */
+template <typename... Ts>
+inline size_t json_cbor_sprint(char* buffer, size_t size, const json_cbor_template& format, const Ts&... args) {
+    detail::string_buffer sbuffer = { buffer, buffer + size };
+    detail::cbor_print(&sbuffer, format, std::index_sequence_for<Ts...> {}, args...);
+    return sbuffer.begin - buffer;
+}
+
+}
@@ -22,10 +22,43 @@
 #define JP_MAX_PLACEHOLDERS 14
 #endif
 
+/* The deepest nesting of arrays and objects that the parser accepts */
+#ifndef JP_MAX_NESTING
+#define JP_MAX_NESTING 256
+#endif
+
 /* CONSTEXPR PARSER */
 
 namespace JsonPrint {
 
+/**
+ * Formatting selected by a placeholder specifier, e.g. ?{.3f} or ?{x}
+ */
+struct json_print_spec {
+    /** 
+     * 'f', 'e' or 'g' for numbers, 'x' or 'X' for hexadecimal strings, 'm' for times as 
+     * milliseconds, 's' for a spread placeholder ("...?") of object members, or 0 for the 
+     * default formatting 
+     */
+    char type;
+
+    /** 
+     * Digits after the decimal point for 'f' and 'e', or significant digits for 'g'.
+     * For 's', whether the spread members are preceded (spread_comma_before) or 
+     * followed (spread_comma_after) by a ',' when there are any.
+     */
+    signed char precision;
+
+    /** Length of the placeholder in the format string, including the specifier */
+    unsigned char length;
+};
+
+/** json_print_spec::precision of a spread placeholder that comes after another member */
+constexpr signed char spread_comma_before = 1;
+
+/** json_print_spec::precision of a spread placeholder that comes first, before another member */
+constexpr signed char spread_comma_after = 2;
+
 /**
  * "Parsed" JSON format string structure
 */
@@ -39,26 +72,19 @@ struct json_print_context {
 
     /** Number of parts (or number of placeholders plus one) */
     size_t count;
+
+    /** Specifier of each placeholder */
+    json_print_spec specs[JP_MAX_PLACEHOLDERS];
 };
 
 namespace detail {
 
 constexpr bool is_whitespace(char c) {
-    switch (c) {
-        case JP_WHITESPACE:
-            return true;
-        default: 
-            return false;
-    }
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
 }
 
 constexpr bool is_decimal(char c) {
-    switch(c) {
-        case JP_DIGIT:
-            return true;
-        default:
-            return false;
-    }
+    return c >= '0' && c <= '9';
 }
 
 constexpr bool is_hexadecimal(char c) {
@@ -83,19 +109,34 @@ constexpr bool is_string_char(char c) {
     }
 }
 
+// The loops below count with an index instead of incrementing the pointer, which is
+// much cheaper for compilers to evaluate in constant expressions
+
 constexpr const char* skip_whitespace(const char* begin, const char* end) {
-    for (; begin != end && is_whitespace(*begin); begin++) {}
-    return begin;
+    size_t i = 0;
+    for (size_t size = end - begin; i != size && is_whitespace(begin[i]); i++) {}
+    return begin + i;
 }
 
 constexpr const char* skip_decimal(const char* begin, const char* end) {
-    for (; begin != end && is_decimal(*begin); begin++) {}
-    return begin;
+    size_t i = 0;
+    for (size_t size = end - begin; i != size && is_decimal(begin[i]); i++) {}
+    return begin + i;
+}
+
+/** Skips characters that don't need checking inside a string */
+constexpr const char* skip_string_chars(const char* begin, const char* end) {
+    size_t i = 0;
+    for (size_t size = end - begin; i != size && static_cast<unsigned char>(begin[i]) >= 0x20 && begin[i] != '"' && begin[i] != '\\'; i++) {}
+    return begin + i;
 }
 
 constexpr const char* parse_string(const char* begin, const char* end) {
     begin++; // skip opening quote
     while (begin != end) {
+        begin = skip_string_chars(begin, end);
+        if (begin == end)
+            break;
         switch(*begin) {
             case JP_CONTROL:
                 throw std::runtime_error("control characters not allowed inside strings");
@@ -135,7 +176,7 @@ constexpr const char* parse_string(const char* begin, const char* end) {
                 begin++;
         }
     }
-    return begin;
+    throw std::runtime_error(R"(expected '"', reached end of text)");
 }
 
 constexpr const char* parse_number(const char* begin, const char* end) {
@@ -191,39 +232,100 @@ constexpr const char* parse_number(const char* begin, const char* end) {
 }
 
 constexpr const char* parse_null(const char* begin, const char* end) {
-    if (end - begin < 4 && (
-        *(begin + 1) != 'u' || 
-        *(begin + 2) != 'l' || 
-        *(begin + 3) != 'l')) {
+    if (end - begin < 4 ||
+        begin[1] != 'u' ||
+        begin[2] != 'l' ||
+        begin[3] != 'l') {
         throw std::runtime_error("unrecognized token");
     }
     return begin + 4;
 }
 
 constexpr const char* parse_true(const char* begin, const char* end) {
-    if (end - begin < 4 && (
-        *(begin + 1) != 'r' || 
-        *(begin + 2) != 'u' || 
-        *(begin + 3) != 'e')) {
+    if (end - begin < 4 ||
+        begin[1] != 'r' ||
+        begin[2] != 'u' ||
+        begin[3] != 'e') {
         throw std::runtime_error("unrecognized token");
     }
     return begin + 4;
 }
 
 constexpr const char* parse_false(const char* begin, const char* end) {
-    if (end - begin < 5 && (
-        *(begin + 1) != 'a' || 
-        *(begin + 2) != 'l' || 
-        *(begin + 3) != 's' ||
-        *(begin + 4) != 'e')) {
+    if (end - begin < 5 ||
+        begin[1] != 'a' ||
+        begin[2] != 'l' ||
+        begin[3] != 's' ||
+        begin[4] != 'e') {
         throw std::runtime_error("unrecognized token");
     }
     return begin + 5;
 }
 
-constexpr const char* parse_value(const char* begin, const char* end, json_print_context& context);
+/**
+ * Parses a placeholder specifier: "{", an optional "." and precision, an optional type, and "}"
+ */
+constexpr const char* parse_spec(const char* begin, const char* end, json_print_spec& spec) {
+    begin++; // skip opening brace
+    spec.precision = -1;
+    if (begin != end && *begin == '.') {
+        begin++;
+        const char* digits = begin;
+        spec.precision = 0;
+        for (; begin != end && is_decimal(*begin); begin++)
+            spec.precision = static_cast<signed char>(spec.precision * 10 + (*begin - '0'));
+        if (begin == digits || begin - digits > 2)
+            throw std::runtime_error("expected precision of 0 to 99 digits");
+    }
+    if (begin == end)
+        throw std::runtime_error("expected '}'");
+    switch (*begin) {
+        case 'f':
+        case 'e':
+        case 'g':
+            spec.type = *begin++;
+            break;
+
+        case 'x':
+        case 'X':
+            if (spec.precision != -1)
+                throw std::runtime_error("hexadecimal specifier doesn't take a precision");
+            spec.type = *begin++;
+            break;
+
+        case 'm':
+            if (spec.precision != -1 || end - begin < 2 || begin[1] != 's')
+                throw std::runtime_error("expected 'ms'");
+            spec.type = 'm';
+            begin += 2;
+            break;
+
+        case '}':
+            // precision alone caps the significant digits
+            if (spec.precision == -1)
+                throw std::runtime_error("expected specifier type");
+            spec.type = 'g';
+            break;
+
+        default:
+            throw std::runtime_error("unrecognized specifier type");
+    }
+    if (begin == end || *begin != '}')
+        throw std::runtime_error("expected '}'");
+    return begin + 1;
+}
+
+/**
+ * Start of the literal part that follows a placeholder, or of the format string for the first part
+ */
+constexpr const char* part_begin(const json_print_context& context, size_t part) {
+    return part == 0 ? context.parts[0] : context.parts[part] + context.specs[part - 1].length;
+}
 
-constexpr const char* parse_array(const char* begin, const char* end, json_print_context& context) {
+/** Parses one value, with depth arrays and objects around it */
+constexpr const char* parse_value(const char* begin, const char* end, json_print_context& context, size_t depth = 0);
+
+constexpr const char* parse_array(const char* begin, const char* end, json_print_context& context, size_t depth) {
     begin++;
     begin = skip_whitespace(begin, end);
 
@@ -235,7 +337,7 @@ constexpr const char* parse_array(const char* begin, const char* end, json_print
 
     while (true) {
         // parse value
-        begin = parse_value(begin, end, context);
+        begin = parse_value(begin, end, context, depth);
 
         // parse ',' or ']'
         begin = skip_whitespace(begin, end);
@@ -249,7 +351,47 @@ constexpr const char* parse_array(const char* begin, const char* end, json_print
     }
 }
 
-constexpr const char* parse_object(const char* begin, const char* end, json_print_context& context) {
+/**
+ * Parses a spread placeholder "...?" in place of object members. The placeholder takes
+ * the ',' that separates it from the member before it, or else from the member after 
+ * it, so that nothing is left between the other members when there's nothing to spread.
+ * Returns the location of the ',' or '}' that follows, or of the next member when
+ * the ',' was taken.
+ */
+constexpr const char* parse_spread(const char* begin, const char* end, const char* comma, json_print_context& context) {
+    if (end - begin < 4 || begin[1] != '.' || begin[2] != '.' || begin[3] != '?')
+        throw std::runtime_error("expected '...?'");
+    if (context.count == JP_MAX_PLACEHOLDERS) // last slot is reserved for end
+        throw std::runtime_error("too many placeholder values");
+    context.count++;
+    const char* spread = begin;
+    const char* placeholder = comma != nullptr ? comma : spread;
+    context.parts[context.count] = placeholder;
+    json_print_spec& spec = context.specs[context.count - 1];
+    spec.type = 's';
+
+    begin = skip_whitespace(spread + 4, end);
+    if (begin == end)
+        throw std::runtime_error("expected ',' or '}', reached end of text");
+    if (*begin != ',' && *begin != '}')
+        throw std::runtime_error("expected ',' or '}'");
+    if (comma == nullptr && *begin == ',') {
+        // first member, so it takes the ',' after it, and a member must follow
+        begin = skip_whitespace(begin + 1, end);
+        if (begin == end || *begin != '"')
+            throw std::runtime_error(R"(expected '"' after a leading '...?')");
+        spec.precision = spread_comma_after;
+        spec.length = static_cast<unsigned char>(begin - placeholder);
+    } else {
+        spec.precision = comma != nullptr ? spread_comma_before : 0;
+        spec.length = static_cast<unsigned char>(spread + 4 - placeholder);
+    }
+    if (begin - placeholder > 255)
+        throw std::runtime_error("too much whitespace around '...?'");
+    return begin;
+}
+
+constexpr const char* parse_object(const char* begin, const char* end, json_print_context& context, size_t depth) {
     begin++;
     begin = skip_whitespace(begin, end);
 
@@ -258,45 +400,64 @@ constexpr const char* parse_object(const char* begin, const char* end, json_prin
         throw std::runtime_error(R"(expected '"' or '}', reached end of text)");
     if (*begin == '}')
         return begin + 1;
-    if (*begin != '"')
-        throw std::runtime_error(R"(expected '"' or '}')");
+    if (*begin != '"' && *begin != '.')
+        throw std::runtime_error(R"(expected '"', '...?' or '}')");
 
+    // the ',' before the current member, if any
+    const char* comma = nullptr;
     while (true) {
-        // parse member name
-        begin = parse_string(begin, end);
-        begin = skip_whitespace(begin, end);
-
-        // parse ':'
-        if (begin == end)
-            throw std::runtime_error("expected ':', reached end of text");
-        if (*begin != ':')
-            throw std::runtime_error("expected ':'");
-        begin++;
-        
-        // parse value
-        begin = parse_value(begin, end, context);
-        begin = skip_whitespace(begin, end);
+        if (*begin == '.') {
+            // a leading spread placeholder takes the ',' after it
+            begin = parse_spread(begin, end, comma, context);
+            if (*begin == '"')
+                continue;
+        } else {
+            // parse member name
+            begin = parse_string(begin, end);
+            begin = skip_whitespace(begin, end);
+
+            // parse ':'
+            if (begin == end)
+                throw std::runtime_error("expected ':', reached end of text");
+            if (*begin != ':')
+                throw std::runtime_error("expected ':'");
+            begin++;
+            
+            // parse value
+            begin = parse_value(begin, end, context, depth);
+            begin = skip_whitespace(begin, end);
+            if (begin == end)
+                throw std::runtime_error("expected ',' or '}', reached end of text");
+        }
 
         // parse ',' or '}'
-        if (begin == end)
-            throw std::runtime_error("expected ',' or '}', reached end of text");
         if (*begin == '}')
             return begin + 1;
         if (*begin != ',')
             throw std::runtime_error("expected ',' or '}'");
-        begin++;
+        comma = begin++;
         begin = skip_whitespace(begin, end);
+        if (begin == end)
+            throw std::runtime_error(R"(expected '"' or '...?', reached end of text)");
+        if (*begin != '"' && *begin != '.')
+            throw std::runtime_error(R"(expected '"' or '...?')");
     }
 }
 
-constexpr const char* parse_value(const char* begin, const char* end, json_print_context& context) {
+constexpr const char* parse_value(const char* begin, const char* end, json_print_context& context, size_t depth) {
     begin = skip_whitespace(begin, end);
+    if (begin == end)
+        throw std::runtime_error("expected value, reached end of text");
     switch(*begin) {
         case '[':
-            return parse_array(begin, end, context);
+            if (depth == JP_MAX_NESTING)
+                throw std::runtime_error("arrays and objects nested too deeply");
+            return parse_array(begin, end, context, depth + 1);
 
         case '{':
-            return parse_object(begin, end, context);
+            if (depth == JP_MAX_NESTING)
+                throw std::runtime_error("arrays and objects nested too deeply");
+            return parse_object(begin, end, context, depth + 1);
 
         case '\"':
             return parse_string(begin, end);
@@ -319,7 +480,13 @@ constexpr const char* parse_value(const char* begin, const char* end, json_print
                 throw std::runtime_error("too many placeholder values");
             context.count++;
             context.parts[context.count] = begin;
-            begin++;
+            {
+                json_print_spec& spec = context.specs[context.count - 1];
+                const char* placeholder = begin++;
+                if (begin != end && *begin == '{')
+                    begin = parse_spec(begin, end, spec);
+                spec.length = static_cast<unsigned char>(begin - placeholder);
+            }
             break;
 
         default:
@@ -0,0 +1,252 @@
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Optional parallel printing of large containers. Include after json_print.hpp,
+ * and link with the platform's thread library.
+ */
+
+namespace JsonPrint {
+
+/**
+ * Fixed set of threads that run batches of tasks. The thread calling run
+ * also works on the batch, so a pool of size N starts N - 1 threads.
+ * Batches from different threads run one after the other, and a task that
+ * runs a batch itself runs it on its own thread.
+ */
+class json_worker_pool {
+public:
+    explicit json_worker_pool(unsigned size = std::thread::hardware_concurrency())
+        : concurrency((std::max)(size, 1u)) {
+        for (unsigned i = 1; i < concurrency; i++)
+            workers.emplace_back([this]() { work_loop(); });
+    }
+
+    json_worker_pool(const json_worker_pool&) = delete;
+    json_worker_pool& operator=(const json_worker_pool&) = delete;
+
+    ~json_worker_pool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers)
+            worker.join();
+    }
+
+    /** Number of threads working on each batch, including the calling thread */
+    unsigned size() const {
+        return concurrency;
+    }
+
+    /**
+     * Calls task(i) for each i in [0, count) across the pool, and returns
+     * once all of them have completed
+     */
+    void run(size_t count, const std::function<void(size_t)>& task) {
+        // the pool's threads may all be waiting for this task to return, so a nested batch can't go to them
+        if (inside_task()) {
+            for (size_t i = 0; i < count; i++)
+                task(i);
+            return;
+        }
+
+        std::lock_guard<std::mutex> running(run_mutex);
+        std::unique_lock<std::mutex> lock(mutex);
+        job = &task;
+        job_count = count;
+        finished = 0;
+        next = 0;
+        generation++;
+        lock.unlock();
+        wake.notify_all();
+
+        size_t worked = work(task, count);
+
+        lock.lock();
+        finished += worked;
+        // wait for workers still holding this job, so none of them starts on the next one
+        done.wait(lock, [&]() { return finished == job_count && active == 0; });
+        job = nullptr;
+    }
+
+private:
+    /** Whether the current thread is running a task of any pool */
+    static bool& inside_task() {
+        static thread_local bool inside = false;
+        return inside;
+    }
+
+    struct task_scope {
+        task_scope() { inside_task() = true; }
+        ~task_scope() { inside_task() = false; }
+    };
+
+    size_t work(const std::function<void(size_t)>& task, size_t count) {
+        task_scope scope;
+        size_t worked = 0;
+        for (size_t i = next++; i < count; i = next++, worked++)
+            task(i);
+        return worked;
+    }
+
+    void work_loop() {
+        unsigned seen = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [&]() { return stopping || (generation != seen && job != nullptr); });
+            if (stopping)
+                return;
+            seen = generation;
+            const std::function<void(size_t)>& task = *job;
+            size_t count = job_count;
+            active++;
+            lock.unlock();
+
+            size_t worked = work(task, count);
+
+            lock.lock();
+            active--;
+            finished += worked;
+            if (finished == job_count && active == 0)
+                done.notify_all();
+        }
+    }
+
+    unsigned concurrency;
+    std::vector<std::thread> workers;
+    std::mutex run_mutex;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(size_t)>* job = nullptr;
+    size_t job_count = 0;
+    size_t finished = 0;
+    unsigned active = 0;
+    unsigned generation = 0;
+    bool stopping = false;
+    std::atomic<size_t> next { 0 };
+};
+
+/**
+ * Pool used by parallel arguments that don't specify one, sized to the number of cores
+ */
+inline json_worker_pool& json_default_worker_pool() {
+    static json_worker_pool pool;
+    return pool;
+}
+
+struct json_parallel_options {
+    /** Containers with fewer elements than this are printed serially */
+    size_t threshold = 65536;
+
+    /** Number of elements formatted by each task */
+    size_t chunk_size = 16384;
+
+    /** Pool to format on, or the default pool if null */
+    json_worker_pool* pool = nullptr;
+};
+
+namespace detail {
+
+template <typename T>
+struct is_json_object : std::false_type {};
+
+template <typename K, typename V, typename... Ts>
+struct is_json_object<std::map<K, V, Ts...>> : std::true_type {};
+
+template <typename K, typename V, typename... Ts>
+struct is_json_object<std::unordered_map<K, V, Ts...>> : std::true_type {};
+
+/**
+ * Container printed by formatting chunks of its elements concurrently
+ */
+template <typename T>
+struct json_parallel_arg {
+    const T& container;
+    json_parallel_options options;
+};
+
+template <typename Dest, typename T>
+inline void json_print_parallel_element(Dest dest, const T& element, std::false_type) {
+    json_print_element(dest, element);
+}
+
+template <typename Dest, typename T>
+inline void json_print_parallel_element(Dest dest, const T& member, std::true_type) {
+    json_print_arg(dest, member.first);
+    write_char(dest, ':');
+    json_print_element(dest, member.second);
+}
+
+template <typename Dest, typename T>
+inline void json_print_arg(Dest dest, const json_parallel_arg<T>& n) {
+    using is_object = is_json_object<T>;
+    const T& container = n.container;
+    json_worker_pool& pool = n.options.pool ? *n.options.pool : json_default_worker_pool();
+    size_t size = container.size();
+    if (size < n.options.threshold || pool.size() < 2) {
+        json_print_arg(dest, container);
+        return;
+    }
+
+    // format a few chunks per thread at a time, so memory use doesn't grow with the container
+    using iterator = decltype(container.begin());
+    size_t chunk_size = (std::max)(n.options.chunk_size, size_t(1));
+    std::vector<iterator> chunks(pool.size() * 2 + 1, container.end());
+    std::vector<std::string> buffers(pool.size() * 2);
+    iterator it = container.begin();
+    size_t printed = 0;
+
+    write_char(dest, is_object::value ? '{' : '[');
+    while (printed < size) {
+        bool first_wave = printed == 0;
+        size_t count = 0;
+        for (; count < buffers.size() && printed < size; count++) {
+            size_t length = (std::min)(chunk_size, size - printed);
+            chunks[count] = it;
+            std::advance(it, length);
+            printed += length;
+        }
+        chunks[count] = it;
+
+        pool.run(count, [&](size_t i) {
+            std::string& buffer = buffers[i];
+            buffer.clear();
+            for (iterator element = chunks[i]; element != chunks[i + 1]; ++element) {
+                // every element except the very first one is preceded by a separator
+                if (!first_wave || i != 0 || element != chunks[0])
+                    write_char(&buffer, ',');
+                json_print_parallel_element(&buffer, *element, is_object {});
+            }
+        });
+
+        for (size_t i = 0; i < count; i++)
+            write_string(dest, buffers[i].data(), buffers[i].data() + buffers[i].size());
+    }
+    write_char(dest, is_object::value ? '}' : ']');
+}
+
+}
+
+/**
+ * Wraps a container as a placeholder argument that is printed by formatting chunks
+ * of its elements concurrently on a worker pool. std::map and std::unordered_map
+ * are printed as objects, other containers as arrays.
+ */
+template <typename T>
+inline detail::json_parallel_arg<T> json_parallel(const T& container, json_parallel_options options = {}) {
+    return { container, options };
+}
+
+}
@@ -0,0 +1,457 @@
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <new>
+#include <sched.h>
+#include <stdexcept>
+#include <string.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#include <utility>
+
+/*
+ * Optional sink that hands records to another process through a ring buffer in
+ * POSIX shared memory. Include after json_print.hpp. Linux only, since waiting
+ * uses futexes.
+ */
+
+namespace JsonPrint {
+
+struct json_shm_options {
+    /** Wait for the reader to make room when the ring is full, instead of dropping the record */
+    bool block = true;
+
+    /** Serialize writers, so that several threads or processes can write to the same ring */
+    bool multi_producer = false;
+};
+
+namespace detail {
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2,
+    "the shared memory ring needs lock-free atomics, which work across processes");
+
+/**
+ * Control block at the start of the shared memory, followed by the ring's data.
+ * Positions only grow, and are wrapped with the capacity mask when used as offsets.
+ */
+struct shm_ring_header {
+    uint64_t magic;
+    uint64_t capacity;
+    alignas(64) std::atomic<uint64_t> write_position;
+    std::atomic<uint32_t> data_sequence;
+    std::atomic<uint32_t> reader_waiting;
+    std::atomic<uint32_t> writer_lock;
+    alignas(64) std::atomic<uint64_t> read_position;
+    std::atomic<uint32_t> space_sequence;
+    std::atomic<uint32_t> writer_waiting;
+};
+
+const uint64_t shm_ring_magic = 0x6a736f6e72696e67; // "jsonring"
+
+/** Records are framed by a 4 byte length, and start at multiples of 8 bytes */
+const uint32_t shm_frame_size = 4;
+const uint32_t shm_frame_padding = UINT32_MAX;
+
+inline uint64_t shm_align(uint64_t position) {
+    return (position + 7) & ~uint64_t(7);
+}
+
+inline uint32_t* futex_word(std::atomic<uint32_t>& word) {
+    return reinterpret_cast<uint32_t*>(&word);
+}
+
+/** Waits until the word no longer has the given value, or the timeout (-1 for none) passes */
+inline void futex_wait(std::atomic<uint32_t>& word, uint32_t value, int timeout_ms) {
+    struct timespec timeout = { timeout_ms / 1000, (timeout_ms % 1000) * 1000000L };
+    syscall(SYS_futex, futex_word(word), FUTEX_WAIT, value, timeout_ms < 0 ? nullptr : &timeout, nullptr, 0);
+}
+
+inline void futex_wake(std::atomic<uint32_t>& word) {
+    syscall(SYS_futex, futex_word(word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+}
+
+/**
+ * Mapping of a ring buffer in POSIX shared memory, created by one process and
+ * opened by name in others
+ */
+class json_shm_ring {
+public:
+    /**
+     * Creates (or replaces) the shared memory object with a ring of the given capacity,
+     * which must be a power of two
+     */
+    static json_shm_ring create(const char* name, size_t capacity) {
+        if (capacity < 64 || (capacity & (capacity - 1)) != 0 || capacity > UINT32_MAX)
+            throw std::runtime_error("shared memory ring capacity must be a power of two");
+        int fd = shm_open(name, O_CREAT | O_RDWR | O_TRUNC, 0600);
+        if (fd < 0)
+            throw std::runtime_error("failed to create shared memory");
+        if (ftruncate(fd, sizeof(detail::shm_ring_header) + capacity) != 0) {
+            close(fd);
+            throw std::runtime_error("failed to size shared memory");
+        }
+        json_shm_ring ring(fd, sizeof(detail::shm_ring_header) + capacity);
+        detail::shm_ring_header* header = new (ring.header) detail::shm_ring_header();
+        header->capacity = capacity;
+        header->magic = detail::shm_ring_magic;
+        return ring;
+    }
+
+    /**
+     * Opens a ring created by another process
+     */
+    static json_shm_ring open(const char* name) {
+        int fd = shm_open(name, O_RDWR, 0);
+        if (fd < 0)
+            throw std::runtime_error("failed to open shared memory");
+        struct stat info;
+        if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(detail::shm_ring_header)) {
+            close(fd);
+            throw std::runtime_error("shared memory is not a ring");
+        }
+        json_shm_ring ring(fd, info.st_size);
+        if (ring.header->magic != detail::shm_ring_magic || ring.header->capacity + sizeof(detail::shm_ring_header) != ring.size)
+            throw std::runtime_error("shared memory is not a ring");
+        return ring;
+    }
+
+    /**
+     * Removes the name of a shared memory object. Existing mappings stay valid.
+     */
+    static void unlink(const char* name) {
+        shm_unlink(name);
+    }
+
+    json_shm_ring(json_shm_ring&& other) noexcept : header(other.header), size(other.size) {
+        other.header = nullptr;
+    }
+
+    json_shm_ring(const json_shm_ring&) = delete;
+    json_shm_ring& operator=(const json_shm_ring&) = delete;
+
+    ~json_shm_ring() {
+        if (header != nullptr)
+            munmap(header, size);
+    }
+
+    /** Size of the ring's data in bytes */
+    size_t capacity() const {
+        return header->capacity;
+    }
+
+    detail::shm_ring_header* control() const {
+        return header;
+    }
+
+    char* data() const {
+        return reinterpret_cast<char*>(header + 1);
+    }
+
+private:
+    json_shm_ring(int fd, size_t size) : header(nullptr), size(size) {
+        void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (memory == MAP_FAILED)
+            throw std::runtime_error("failed to map shared memory");
+        header = static_cast<detail::shm_ring_header*>(memory);
+    }
+
+    detail::shm_ring_header* header;
+    size_t size;
+};
+
+namespace detail {
+
+/**
+ * Sink that formats each record directly into free space of the ring, and publishes
+ * it with its length once complete. Records that run into the end of the ring, or
+ * into unread data, are collected on the side and copied in when there's room.
+ */
+class shm_writer {
+public:
+    shm_writer(json_shm_ring& ring, json_shm_options options = {})
+        : header(ring.control()), data(ring.data()), mask(ring.capacity() - 1), options(options) {}
+
+    shm_writer(const shm_writer&) = delete;
+    shm_writer& operator=(const shm_writer&) = delete;
+
+    void begin_record() {
+        if (options.multi_producer)
+            lock();
+        start = header->write_position.load(std::memory_order_relaxed);
+        cursor = start + shm_frame_size;
+        // contiguous free space, up to the end of the ring or to unread data
+        uint64_t ring_end = (start & ~mask) + mask + 1;
+        uint64_t free_end = header->read_position.load(std::memory_order_acquire) + mask + 1;
+        limit = ring_end < free_end ? ring_end : free_end;
+        // without room for the frame, the whole record is collected on the side
+        spilled = limit < cursor;
+        overflow.clear();
+    }
+
+    /**
+     * Publishes the record. Returns false if it was dropped because the ring is full
+     * and the writer doesn't block.
+     */
+    bool end_record() {
+        bool written = false;
+        try {
+            written = spilled ? write_spilled() : (publish(start, cursor - start - shm_frame_size), true);
+        } catch (...) {
+            // a record too large for the ring must not keep the other producers waiting
+            if (options.multi_producer)
+                unlock();
+            throw;
+        }
+        if (!written)
+            dropped_records++;
+        if (options.multi_producer)
+            unlock();
+        return written;
+    }
+
+    /** Ends a record without publishing it */
+    void abandon_record() {
+        if (options.multi_producer)
+            unlock();
+    }
+
+    /** Records dropped because the ring was full */
+    unsigned long long dropped() const {
+        return dropped_records;
+    }
+
+    void write(const char* begin, const char* end) {
+        size_t size = end - begin;
+        if (!spilled && cursor + size <= limit) {
+            memcpy(data + (cursor & mask), begin, size);
+            cursor += size;
+            return;
+        }
+        if (!spilled) {
+            // move the record written so far to the side
+            overflow.assign(data + ((start + shm_frame_size) & mask), cursor - start - shm_frame_size);
+            spilled = true;
+        }
+        overflow.append(begin, end);
+    }
+
+    void write(char c) {
+        if (!spilled && cursor < limit) {
+            data[cursor & mask] = c;
+            cursor++;
+            return;
+        }
+        write(&c, &c + 1);
+    }
+
+    template <typename... T>
+    int write_printf(const char* format, T&&... args) {
+        return format_printf([this](const char* text, const char* text_end) { write(text, text_end); }, format, args...);
+    }
+
+private:
+    bool write_spilled() {
+        uint64_t capacity = mask + 1;
+        uint64_t needed = shm_align(shm_frame_size + overflow.size());
+        if (needed > capacity / 2)
+            throw std::runtime_error("record is too large for the shared memory ring");
+
+        // a record that doesn't fit before the end of the ring starts over at its beginning
+        uint64_t position = header->write_position.load(std::memory_order_relaxed);
+        uint64_t padding = (position & mask) + needed > capacity ? capacity - (position & mask) : 0;
+        if (!wait_for_space(position + padding + needed))
+            return false;
+        if (padding != 0) {
+            memcpy(data + (position & mask), &shm_frame_padding, shm_frame_size);
+            position += padding;
+        }
+        memcpy(data + ((position + shm_frame_size) & mask), overflow.data(), overflow.size());
+        publish(position, overflow.size());
+        return true;
+    }
+
+    /** Waits until everything before end has been read */
+    bool wait_for_space(uint64_t end) {
+        uint64_t capacity = mask + 1;
+        while (end - header->read_position.load(std::memory_order_acquire) > capacity) {
+            if (!options.block)
+                return false;
+            uint32_t sequence = header->space_sequence.load();
+            header->writer_waiting.store(1);
+            if (end - header->read_position.load() > capacity)
+                futex_wait(header->space_sequence, sequence, 100);
+            header->writer_waiting.store(0);
+        }
+        return true;
+    }
+
+    void publish(uint64_t position, size_t size) {
+        uint32_t frame = static_cast<uint32_t>(size);
+        memcpy(data + (position & mask), &frame, shm_frame_size);
+        header->write_position.store(shm_align(position + shm_frame_size + size), std::memory_order_release);
+        header->data_sequence.fetch_add(1);
+        // only the first record after the reader went to sleep wakes it
+        if (header->reader_waiting.load() != 0 && header->reader_waiting.exchange(0) != 0)
+            futex_wake(header->data_sequence);
+    }
+
+    void lock() {
+        uint32_t unlocked = 0;
+        while (!header->writer_lock.compare_exchange_weak(unlocked, 1, std::memory_order_acquire)) {
+            unlocked = 0;
+            sched_yield();
+        }
+    }
+
+    void unlock() {
+        header->writer_lock.store(0, std::memory_order_release);
+    }
+
+    shm_ring_header* header;
+    char* data;
+    uint64_t mask;
+    json_shm_options options;
+    uint64_t start = 0;
+    uint64_t cursor = 0;
+    uint64_t limit = 0;
+    bool spilled = false;
+    std::string overflow;
+    unsigned long long dropped_records = 0;
+};
+
+inline void write_char(shm_writer* writer, const char c) {
+    writer->write(c);
+}
+
+inline int write_string(shm_writer* writer, const char* begin, const char* end) {
+    writer->write(begin, end);
+    return static_cast<int>(end - begin);
+}
+
+inline int write_string_unsafe(shm_writer* writer, const char* text) {
+    return write_string(writer, text, text + strlen(text));
+}
+
+template <typename... T>
+int write_printf(shm_writer* writer, const char* format, T&&... args) {
+    return writer->write_printf(format, std::forward<T>(args)...);
+}
+
+}
+
+/**
+ * Writer that formats records directly into a shared memory ring
+ */
+using json_shm_writer = detail::shm_writer;
+
+/**
+ * Reads records from a shared memory ring, in the order they were written
+ */
+class json_shm_reader {
+public:
+    explicit json_shm_reader(json_shm_ring& ring)
+        : header(ring.control()), data(ring.data()), mask(ring.capacity() - 1) {}
+
+    /**
+     * Calls f(const char* data, size_t size) with the next record, which points into
+     * the ring and is only valid during the call. Waits for a record for up to
+     * timeout_ms milliseconds (-1 to wait indefinitely), and returns false if none arrived.
+     */
+    template <typename F>
+    bool read(F&& f, int timeout_ms = -1) {
+        if (!wait_for_data(timeout_ms))
+            return false;
+        uint64_t position = header->read_position.load(std::memory_order_relaxed);
+        uint32_t frame;
+        memcpy(&frame, data + (position & mask), detail::shm_frame_size);
+        if (frame == detail::shm_frame_padding) {
+            // skip to the start of the ring, where the record continues
+            position += mask + 1 - (position & mask);
+            memcpy(&frame, data + (position & mask), detail::shm_frame_size);
+        }
+        f(static_cast<const char*>(data + ((position + detail::shm_frame_size) & mask)), static_cast<size_t>(frame));
+        header->read_position.store(detail::shm_align(position + detail::shm_frame_size + frame), std::memory_order_release);
+        header->space_sequence.fetch_add(1);
+        if (header->writer_waiting.load() != 0)
+            detail::futex_wake(header->space_sequence);
+        return true;
+    }
+
+    /**
+     * Copies the next record into a string
+     */
+    bool read(std::string& record, int timeout_ms = -1) {
+        return read([&](const char* begin, size_t size) { record.assign(begin, size); }, timeout_ms);
+    }
+
+private:
+    bool has_data() const {
+        return header->write_position.load(std::memory_order_acquire) != header->read_position.load(std::memory_order_relaxed);
+    }
+
+    bool wait_for_data(int timeout_ms) {
+        if (has_data())
+            return true;
+        if (timeout_ms == 0)
+            return false;
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        long long deadline_ms = deadline.tv_sec * 1000LL + deadline.tv_nsec / 1000000 + timeout_ms;
+        while (true) {
+            uint32_t sequence = header->data_sequence.load();
+            header->reader_waiting.store(1);
+            if (has_data())
+                break;
+            int remaining = -1;
+            if (timeout_ms > 0) {
+                struct timespec now;
+                clock_gettime(CLOCK_MONOTONIC, &now);
+                long long left = deadline_ms - (now.tv_sec * 1000LL + now.tv_nsec / 1000000);
+                if (left <= 0)
+                    break;
+                remaining = static_cast<int>(left);
+            }
+            detail::futex_wait(header->data_sequence, sequence, remaining);
+            // let a busy writer add more records, so that they're read in a batch
+            sched_yield();
+        }
+        header->reader_waiting.store(0);
+        return has_data();
+    }
+
+    detail::shm_ring_header* header;
+    char* data;
+    uint64_t mask;
+};
+
+/**
+ * Prints one record into a shared memory ring. Returns false if the record was
+ * dropped because the ring is full and the writer doesn't block.
+ */
+template <typename... Ts>
+inline bool json_shm_print(json_shm_writer& writer, const json_print_context& context, Ts&&... args) {
+    writer.begin_record();
+    try {
+        detail::json_print(&writer, context, std::forward<Ts>(args)...);
+    } catch (...) {
+        // abandon the record, releasing the lock of a multi-producer ring
+        writer.abandon_record();
+        throw;
+    }
+    return writer.end_record();
+}
+
+}
+
+#define json_shm_print_c(writer, format, ...) ([&](auto&&... jp_args){ constexpr auto x = JsonPrint::compile(format); JP_CHECK_SPREAD(x, jp_args); return JsonPrint::json_shm_print(writer, x, std::forward<decltype(jp_args)>(jp_args)...); }(__VA_ARGS__))
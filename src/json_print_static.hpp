@@ -0,0 +1,95 @@
+#include <cstddef>
+#include <cstdio>
+#include <utility>
+
+/* C++20 API, with the format string as a template argument */
+
+#if defined(__cpp_nontype_template_args) && __cpp_nontype_template_args >= 201911L
+
+namespace JsonPrint {
+namespace detail {
+
+/**
+ * String literal that can be used as a template argument
+ */
+template <size_t N>
+struct fixed_string {
+    char text[N];
+
+    constexpr fixed_string(const char (&format)[N]) {
+        for (size_t i = 0; i < N; i++)
+            text[i] = format[i];
+    }
+};
+
+/**
+ * Format string parsed at compile-time, with each literal part as a constant
+ */
+template <fixed_string Format>
+struct static_format {
+    static constexpr json_print_context context = compile(Format.text, Format.text + sizeof(Format.text) - 1);
+
+    /** Number of placeholders */
+    static constexpr size_t placeholders = context.count - 1;
+
+    template <size_t I>
+    static constexpr const char* part_begin = detail::part_begin(context, I);
+
+    template <size_t I>
+    static constexpr size_t part_size = context.parts[I + 1] - part_begin<I>;
+};
+
+template <fixed_string Format, size_t I, typename Dest>
+inline void json_print_static_part(Dest dest) {
+    using format = static_format<Format>;
+    // the size is a constant, so short parts are written with fixed-size copies
+    if constexpr (format::template part_size<I> > 0)
+        write_string(dest, format::template part_begin<I>, format::template part_begin<I> + format::template part_size<I>);
+}
+
+template <fixed_string Format, typename Dest, size_t... Is, typename... Ts>
+inline void json_print_static(Dest dest, std::index_sequence<Is...>, const Ts&... args) {
+    static_assert(sizeof...(Ts) == static_format<Format>::placeholders, 
+        "number of arguments must match the number of placeholders");
+    static_assert(spreads_match<Ts...>(static_format<Format>::context),
+        "expected a map or a range of pairs with string keys for '...?'");
+    json_print_static_part<Format, 0>(dest);
+    ((json_print_spec_arg(dest, static_format<Format>::context.specs[Is], args), json_print_static_part<Format, Is + 1>(dest)), ...);
+}
+
+}
+
+/**
+ * Prints JSON text to the console. The format string is validated at compile-time,
+ * and the number of arguments must match the number of placeholders.
+ */
+template <detail::fixed_string Format, typename... Ts>
+inline void print(const Ts&... args) {
+    detail::json_print_static<Format>(stdout, std::index_sequence_for<Ts...> {}, args...);
+}
+
+/**
+ * Writes JSON text to a file. The format string is validated at compile-time,
+ * and the number of arguments must match the number of placeholders.
+ */
+template <detail::fixed_string Format, typename... Ts>
+inline void fprint(FILE* file, const Ts&... args) {
+    detail::json_print_static<Format>(file, std::index_sequence_for<Ts...> {}, args...);
+}
+
+/**
+ * Writes null-terminated JSON text to a string buffer. The format string is validated 
+ * at compile-time, and the number of arguments must match the number of placeholders.
+ */
+template <detail::fixed_string Format, typename... Ts>
+inline void sprint(char* buffer, size_t size, const Ts&... args) {
+    if (size == 0)
+        return;
+    detail::string_buffer sbuffer = { buffer, buffer + size - 1 };
+    detail::json_print_static<Format>(&sbuffer, std::index_sequence_for<Ts...> {}, args...);
+    *sbuffer.begin = '\0';
+}
+
+}
+
+#endif
@@ -0,0 +1,171 @@
+#include <initializer_list>
+#include <stdexcept>
+#include <string.h>
+#include <utility>
+
+/*
+ * Optional writer for documents printed a piece at a time. Include after json_print.hpp.
+ */
+
+/* The deepest nesting of arrays and objects in a streamed document */
+#ifndef JP_MAX_STREAM_DEPTH
+#define JP_MAX_STREAM_DEPTH 32
+#endif
+
+namespace JsonPrint {
+namespace detail {
+
+/**
+ * Document of arrays and objects printed one value at a time, keeping a stack of
+ * the open ones to know where a ',' goes
+ */
+template <typename Dest>
+class stream_writer {
+public:
+    explicit stream_writer(Dest dest) : dest(dest) {}
+
+    /** Starts an array, as an element of the open array or as the whole document */
+    void begin_array() {
+        begin('[');
+    }
+
+    /** Starts an array as a member of the open object */
+    void begin_array(const char* name) {
+        begin('[', name);
+    }
+
+    void end_array() {
+        end('[');
+    }
+
+    /** Starts an object, as an element of the open array or as the whole document */
+    void begin_object() {
+        begin('{');
+    }
+
+    /** Starts an object as a member of the open object */
+    void begin_object(const char* name) {
+        begin('{', name);
+    }
+
+    void end_object() {
+        end('{');
+    }
+
+    /** Prints a format string with its arguments as an element of the open array */
+    template <typename... Ts>
+    void element(const json_print_context& context, const Ts&... args) {
+        check_arguments(context, sizeof...(Ts));
+        separate(nullptr);
+        print(context, args...);
+    }
+
+    /** Prints a format string with its arguments as a member of the open object */
+    template <typename... Ts>
+    void member(const char* name, const json_print_context& context, const Ts&... args) {
+        check_arguments(context, sizeof...(Ts));
+        separate(name);
+        print(context, args...);
+    }
+
+    /** Whether the document has a value, and all of its arrays and objects are ended */
+    bool complete() const {
+        return depth == 0 && started;
+    }
+
+    /** Number of arrays and objects that are open */
+    size_t open() const {
+        return depth;
+    }
+
+private:
+    struct frame {
+        char kind;
+        bool first;
+    };
+
+    void begin(char kind, const char* name = nullptr) {
+        if (depth == JP_MAX_STREAM_DEPTH)
+            throw std::logic_error("arrays and objects nested too deeply");
+        separate(name);
+        write_char(dest, kind);
+        stack[depth++] = { kind, true };
+    }
+
+    void end(char kind) {
+        if (depth == 0 || stack[depth - 1].kind != kind)
+            throw std::logic_error(kind == '[' ? "no open array to end" : "no open object to end");
+        depth--;
+        write_char(dest, kind == '[' ? ']' : '}');
+    }
+
+    /** Prints the ',' and the member name that come before a value, if any */
+    void separate(const char* name) {
+        if (depth == 0) {
+            if (started)
+                throw std::logic_error("document already has a value");
+            if (name != nullptr)
+                throw std::logic_error("member outside of an object");
+            started = true;
+            return;
+        }
+        frame& top = stack[depth - 1];
+        if (top.kind == '{' && name == nullptr)
+            throw std::logic_error("expected a member name inside an object");
+        if (top.kind == '[' && name != nullptr)
+            throw std::logic_error("member outside of an object");
+        if (!top.first)
+            write_char(dest, ',');
+        top.first = false;
+        if (name != nullptr) {
+            json_print_string(dest, name, name + strlen(name));
+            write_char(dest, ':');
+        }
+    }
+
+    /** Checked before anything of the value is printed, so a rejected call leaves no trace */
+    void check_arguments(const json_print_context& context, size_t count) const {
+        if (count + 1 != context.count)
+            throw std::logic_error("number of arguments doesn't match the placeholders");
+    }
+
+    template <typename... Ts>
+    void print(const json_print_context& context, const Ts&... args) {
+        json_print_part(dest, context.parts[0], context.parts[1]);
+        size_t index = 0;
+        std::initializer_list<bool> _ { (
+            json_print_spec_arg(dest, context.specs[index], args),
+            index++,
+            json_print_part(dest, part_begin(context, index), context.parts[index + 1]),
+            false
+        )... };
+    }
+
+    Dest dest;
+    frame stack[JP_MAX_STREAM_DEPTH];
+    size_t depth = 0;
+    bool started = false;
+};
+
+}
+
+/**
+ * Writer that prints a JSON document a piece at a time, such as an array of rows
+ * read from a database cursor. Elements and members are printed with compiled
+ * format strings as soon as they're added, and the writer only keeps track of the
+ * open arrays and objects, so its memory doesn't grow with the document. Calls
+ * that would print invalid JSON throw std::logic_error.
+ */
+template <typename Dest>
+using json_stream_writer = detail::stream_writer<Dest>;
+
+/**
+ * Creates a streaming writer that prints to a sink, such as a FILE*, a std::string*
+ * or a pointer to one of the optional writers
+ */
+template <typename Dest>
+inline json_stream_writer<Dest> json_stream(Dest dest) {
+    return json_stream_writer<Dest>(dest);
+}
+
+}
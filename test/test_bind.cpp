@@ -0,0 +1,44 @@
+#include "doctest/doctest.h"
+#include "../src/json_print.hpp"
+#include "../src/json_print_bind.hpp"
+
+TEST_CASE("should bind leading arguments ahead of time") {
+    char buffer[128] = { 0 };
+    constexpr auto context = JsonPrint::compile(R"({"host": ?, "service": ?, "id": ?, "message": ?})");
+    JsonPrint::json_bound_template bound = JsonPrint::json_bind(context, "web-1", std::string("api"));
+    CHECK(bound.str() == R"({"host": "web-1", "service": "api", "id": ?, "message": ?})");
+    json_sprint(buffer, sizeof(buffer), bound, 7, "started");
+    CHECK(std::string(buffer) == R"({"host": "web-1", "service": "api", "id": 7, "message": "started"})");
+}
+
+TEST_CASE("should leave unbound placeholders and their specifiers") {
+    char buffer[128] = { 0 };
+    constexpr auto context = JsonPrint::compile("[?, ?{.2f}, ?{x}]");
+    JsonPrint::json_bound_template bound = JsonPrint::json_bind(context, JsonPrint::json_unbound, 1.0);
+    CHECK(bound.str() == "[?, 1.00, ?{x}]");
+    json_sprint(buffer, sizeof(buffer), bound, "first", 255);
+    CHECK(std::string(buffer) == R"(["first", 1.00, "ff"])");
+}
+
+TEST_CASE("should bind every argument") {
+    char buffer[128] = { 0 };
+    constexpr auto context = JsonPrint::compile(R"({"build": ?, "tags": ?})");
+    JsonPrint::json_bound_template bound = JsonPrint::json_bind(context, 42, std::vector<const char*> { "a?", "b" });
+    JsonPrint::json_sprint(buffer, sizeof(buffer), bound);
+    CHECK(std::string(buffer) == R"({"build": 42, "tags": ["a?","b"]})");
+}
+
+TEST_CASE("should stay valid when moved") {
+    char buffer[128] = { 0 };
+    constexpr auto context = JsonPrint::compile("[?, ?]");
+    std::vector<JsonPrint::json_bound_template> bound;
+    for (int i = 0; i < 20; i++)
+        bound.push_back(JsonPrint::json_bind(context, i));
+    json_sprint(buffer, sizeof(buffer), bound[3], true);
+    CHECK(std::string(buffer) == "[3, true]");
+}
+
+TEST_CASE("should reject more arguments than placeholders") {
+    constexpr auto context = JsonPrint::compile("[?]");
+    CHECK_THROWS(JsonPrint::json_bind(context, 1, 2));
+}
@@ -0,0 +1,186 @@
+#include "doctest/doctest.h"
+#include "../src/json_print.hpp"
+#include "../src/json_print_cbor.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Minimal CBOR decoder, which prints the decoded data as compact JSON
+static const unsigned char* decode_cbor(const unsigned char* data, std::string& json) {
+    unsigned char initial = *data++;
+    unsigned char major = initial >> 5;
+    unsigned char info = initial & 0x1F;
+    if (initial == 0xF4 || initial == 0xF5 || initial == 0xF6) {
+        json += initial == 0xF4 ? "false" : initial == 0xF5 ? "true" : "null";
+        return data;
+    }
+    if (initial == 0xFB) {
+        uint64_t bits = 0;
+        for (int i = 0; i < 8; i++)
+            bits = (bits << 8) | *data++;
+        double n;
+        memcpy(&n, &bits, sizeof(n));
+        char text[32];
+        snprintf(text, sizeof(text), "%g", n);
+        json += text;
+        return data;
+    }
+    if (info == 31) {
+        // indefinite length array
+        json += '[';
+        for (bool first = true; *data != 0xFF; first = false) {
+            if (!first)
+                json += ',';
+            data = decode_cbor(data, json);
+        }
+        json += ']';
+        return data + 1;
+    }
+    uint64_t value = info;
+    if (info >= 24) {
+        value = 0;
+        for (int i = 0; i < (1 << (info - 24)); i++)
+            value = (value << 8) | *data++;
+    }
+    switch (major) {
+        case 0: json += std::to_string(value); return data;
+        case 1: json += std::to_string(-1 - static_cast<long long>(value)); return data;
+        case 3:
+            json += '"';
+            json.append(reinterpret_cast<const char*>(data), value);
+            json += '"';
+            return data + value;
+        case 4:
+        case 5:
+            json += major == 4 ? '[' : '{';
+            for (uint64_t i = 0; i < value; i++) {
+                if (i != 0)
+                    json += ',';
+                data = decode_cbor(data, json);
+                if (major == 5) {
+                    json += ':';
+                    data = decode_cbor(data, json);
+                }
+            }
+            json += major == 4 ? ']' : '}';
+            return data;
+    }
+    throw std::runtime_error("unsupported CBOR data");
+}
+
+static std::string decode_cbor(const char* data, size_t size) {
+    std::string json;
+    const unsigned char* end = decode_cbor(reinterpret_cast<const unsigned char*>(data), json);
+    CHECK(end == reinterpret_cast<const unsigned char*>(data) + size);
+    return json;
+}
+
+TEST_CASE("should encode a template without placeholders") {
+    char buffer[128];
+    constexpr auto format = JsonPrint::compile(R"({"a": [1, -2, 3.5], "b": "c", "d": [true, false, null], "e": {}})");
+    JsonPrint::json_cbor_template cbor = JsonPrint::compile_cbor(format);
+    CHECK(cbor.parts.size() == 1);
+    size_t size = JsonPrint::json_cbor_sprint(buffer, sizeof(buffer), cbor);
+    CHECK(decode_cbor(buffer, size) == R"({"a":[1,-2,3.5],"b":"c","d":[true,false,null],"e":{}})");
+}
+
+TEST_CASE("should encode the exact CBOR bytes") {
+    char buffer[128];
+    constexpr auto format = JsonPrint::compile(R"({"id": ?, "tags": ["x", ?]})");
+    JsonPrint::json_cbor_template cbor = JsonPrint::compile_cbor(format);
+    CHECK(cbor.parts.size() == 3);
+    size_t size = JsonPrint::json_cbor_sprint(buffer, sizeof(buffer), cbor, 500, "y");
+    const char expected[] = "\xA2\x62id\x19\x01\xF4\x64tags\x82\x61x\x61y";
+    CHECK(std::string(buffer, size) == std::string(expected, sizeof(expected) - 1));
+}
+
+TEST_CASE("should encode placeholder arguments") {
+    char buffer[256];
+    constexpr auto format = JsonPrint::compile(R"([?, ?, ?, ?, ?, ?, ?, ?, ?])");
+    JsonPrint::json_cbor_template cbor = JsonPrint::compile_cbor(format);
+    std::vector<int> numbers = { 1, 2, 3 };
+    std::map<std::string, bool> flags = { { "on", true }, { "off", false } };
+    size_t size = JsonPrint::json_cbor_sprint(buffer, sizeof(buffer), cbor,
+        0, -1, 100000, 4294967296ULL, 1.5, "text", numbers, flags, nullptr);
+    CHECK(decode_cbor(buffer, size) == R"([0,-1,100000,4294967296,1.5,"text",[1,2,3],{"off":false,"on":true},null])");
+}
+
+TEST_CASE("should encode lazy arguments as indefinite length arrays") {
+    char buffer[128];
+    constexpr auto format = JsonPrint::compile(R"({"range": ?, "generated": ?})");
+    JsonPrint::json_cbor_template cbor = JsonPrint::compile_cbor(format);
+    std::vector<int> numbers = { 1, 2, 3 };
+    size_t size = JsonPrint::json_cbor_sprint(buffer, sizeof(buffer), cbor,
+        JsonPrint::json_range(numbers.begin() + 1, numbers.end()),
+        JsonPrint::json_generator([](auto&& yield) { yield(1); yield("two"); }));
+    CHECK(decode_cbor(buffer, size) == R"({"range":[2,3],"generated":[1,"two"]})");
+    CHECK(static_cast<unsigned char>(buffer[7]) == 0x9F);
+}
+
+TEST_CASE("should convert raw JSON arguments") {
+    char buffer[128];
+    constexpr auto format = JsonPrint::compile(R"({"raw": ?})");
+    JsonPrint::json_cbor_template cbor = JsonPrint::compile_cbor(format);
+    size_t size = JsonPrint::json_cbor_sprint(buffer, sizeof(buffer), cbor, JsonPrint::json_raw(R"({"a": [1, "b"]})"));
+    CHECK(decode_cbor(buffer, size) == R"({"raw":{"a":[1,"b"]}})");
+    CHECK_THROWS(JsonPrint::json_cbor_sprint(buffer, sizeof(buffer), cbor, JsonPrint::json_raw("[1, ?]")));
+}
+
+TEST_CASE("should convert raw JSON that isn't null-terminated") {
+    char buffer[128];
+    constexpr auto format = JsonPrint::compile(R"([?, ?])");
+    JsonPrint::json_cbor_template cbor = JsonPrint::compile_cbor(format);
+    // the digits after the end mustn't be read as part of the number
+    const char text[] = R"(["a", 42])" "7";
+    std::unique_ptr<char[]> copy(new char[sizeof(text) - 1]);
+    memcpy(copy.get(), text, sizeof(text) - 1);
+    const char* end = copy.get() + sizeof(text) - 2;
+    size_t size = JsonPrint::json_cbor_sprint(buffer, sizeof(buffer), cbor,
+        JsonPrint::json_raw(end - 3, end - 2), JsonPrint::json_raw_validated(copy.get(), end));
+    CHECK(decode_cbor(buffer, size) == R"([4,["a",42]])");
+}
+
+TEST_CASE("should convert large raw JSON arguments") {
+    std::string text = "[";
+    for (int i = 0; i < 100000; i++)
+        text += i == 0 ? "1" : ", 1";
+    text += "]";
+    std::vector<char> buffer(text.size());
+    constexpr auto format = JsonPrint::compile("?");
+    JsonPrint::json_cbor_template cbor = JsonPrint::compile_cbor(format);
+    size_t size = JsonPrint::json_cbor_sprint(buffer.data(), buffer.size(), cbor, JsonPrint::json_raw(text));
+    // array head with a 4-byte count, then one byte per element
+    CHECK(size == 5 + 100000);
+}
+
+TEST_CASE("should decode escapes in template strings") {
+    char buffer[128];
+    constexpr auto format = JsonPrint::compile(R"(["a\"b\\c\u00e9\ud83d\ude00"])");
+    JsonPrint::json_cbor_template cbor = JsonPrint::compile_cbor(format);
+    size_t size = JsonPrint::json_cbor_sprint(buffer, sizeof(buffer), cbor);
+    CHECK(std::string(buffer, size) == "\x81\x6B" "a\"b\\c\xC3\xA9\xF0\x9F\x98\x80");
+}
+
+TEST_CASE("should encode large template integers as floating point") {
+    char buffer[128];
+    constexpr auto format = JsonPrint::compile(R"([-9223372036854775808, 1e300])");
+    JsonPrint::json_cbor_template cbor = JsonPrint::compile_cbor(format);
+    size_t size = JsonPrint::json_cbor_sprint(buffer, sizeof(buffer), cbor);
+    CHECK(decode_cbor(buffer, size) == "[-9223372036854775808,1e+300]");
+}
+
+TEST_CASE("should truncate CBOR data that doesn't fit") {
+    char buffer[4];
+    constexpr auto format = JsonPrint::compile(R"(["hello"])");
+    JsonPrint::json_cbor_template cbor = JsonPrint::compile_cbor(format);
+    CHECK(JsonPrint::json_cbor_sprint(buffer, sizeof(buffer), cbor) == 4);
+}
+
+TEST_CASE("should skip placeholder specifiers in CBOR templates") {
+    char buffer[128];
+    constexpr auto format = JsonPrint::compile(R"({"a": ?{.2f}, "b": ?{x}})");
+    JsonPrint::json_cbor_template cbor = JsonPrint::compile_cbor(format);
+    size_t size = JsonPrint::json_cbor_sprint(buffer, sizeof(buffer), cbor, 1.5, 255);
+    CHECK(decode_cbor(buffer, size) == R"({"a":1.5,"b":255})");
+}
@@ -0,0 +1,112 @@
+#include "doctest/doctest.h"
+#include "../src/json_print.hpp"
+#include "../src/json_print_chrono.hpp"
+#include <chrono>
+#include <ctime>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std::chrono;
+
+static system_clock::time_point from_milliseconds(long long milliseconds) {
+    return system_clock::time_point(duration_cast<system_clock::duration>(std::chrono::milliseconds(milliseconds)));
+}
+
+TEST_CASE("should print a time point as an ISO-8601 string") {
+    char buffer[128] = { 0 };
+    json_sprint_c(buffer, sizeof(buffer), R"({"time": ?})", from_milliseconds(1700000000123));
+    CHECK(std::string(buffer) == R"({"time": "2023-11-14T22:13:20.123Z"})");
+}
+
+TEST_CASE("should print the epoch and times before it") {
+    char buffer[128] = { 0 };
+    json_sprint_c(buffer, sizeof(buffer), "[?, ?, ?]", from_milliseconds(0), from_milliseconds(-1), from_milliseconds(951782400000));
+    CHECK(std::string(buffer) == R"(["1970-01-01T00:00:00.000Z", "1969-12-31T23:59:59.999Z", "2000-02-29T00:00:00.000Z"])");
+}
+
+TEST_CASE("should match strftime across many seconds") {
+    char buffer[128] = { 0 };
+    char expected[128] = { 0 };
+    for (long long second = 0; second < 4102444800; second += 86399 * 7 + 1234) {
+        time_t time = static_cast<time_t>(second);
+        struct tm parts;
+        gmtime_r(&time, &parts);
+        strftime(expected, sizeof(expected), "\"%Y-%m-%dT%H:%M:%S.042Z\"", &parts);
+        json_sprint_c(buffer, sizeof(buffer), "?", from_milliseconds(second * 1000 + 42));
+        REQUIRE(std::string(buffer) == expected);
+    }
+}
+
+TEST_CASE("should reuse the cached second for later milliseconds") {
+    char buffer[128] = { 0 };
+    json_sprint_c(buffer, sizeof(buffer), "?", from_milliseconds(1700000000001));
+    json_sprint_c(buffer, sizeof(buffer), "?", from_milliseconds(1700000000999));
+    CHECK(std::string(buffer) == R"("2023-11-14T22:13:20.999Z")");
+}
+
+TEST_CASE("should print time points with coarser durations") {
+    char buffer[128] = { 0 };
+    json_sprint_c(buffer, sizeof(buffer), "?", time_point_cast<seconds>(from_milliseconds(1700000000999)));
+    CHECK(std::string(buffer) == R"("2023-11-14T22:13:20.000Z")");
+}
+
+TEST_CASE("should print a time point as epoch milliseconds with a specifier") {
+    char buffer[128] = { 0 };
+    json_sprint_c(buffer, sizeof(buffer), R"({"time": ?{ms}})", from_milliseconds(1700000000123));
+    CHECK(std::string(buffer) == R"({"time": 1700000000123})");
+}
+
+TEST_CASE("should print durations") {
+    char buffer[128] = { 0 };
+    json_sprint_c(buffer, sizeof(buffer), "[?, ?, ?{ms}, ?{ms}]", milliseconds(1500), -seconds(2), microseconds(2500), minutes(1));
+    CHECK(std::string(buffer) == R"(["PT1.500S", "-PT2.000S", 2, 60000])");
+}
+
+TEST_CASE("should print time points and durations to a file") {
+    FILE* file = tmpfile();
+    REQUIRE(file != nullptr);
+    json_fprint_c(file, "[?, ?, ?{ms}]", from_milliseconds(1700000000123), milliseconds(1500), seconds(2));
+    char buffer[128] = { 0 };
+    rewind(file);
+    fread(buffer, 1, sizeof(buffer) - 1, file);
+    fclose(file);
+    CHECK(std::string(buffer) == R"(["2023-11-14T22:13:20.123Z", "PT1.500S", 2000])");
+}
+
+TEST_CASE("should print time points and durations in containers to a file") {
+    FILE* file = tmpfile();
+    REQUIRE(file != nullptr);
+    std::vector<system_clock::time_point> times = { from_milliseconds(0), from_milliseconds(1700000000123) };
+    std::map<std::string, milliseconds> durations = { { "a", milliseconds(1500) } };
+    json_fprint_c(file, "[?, ?, ?]", times, durations, std::make_pair(seconds(2), from_milliseconds(0)));
+    char buffer[256] = { 0 };
+    rewind(file);
+    fread(buffer, 1, sizeof(buffer) - 1, file);
+    fclose(file);
+    CHECK(std::string(buffer) == R"([["1970-01-01T00:00:00.000Z","2023-11-14T22:13:20.123Z"], {"a":"PT1.500S"}, ["PT2.000S","1970-01-01T00:00:00.000Z"]])");
+}
+
+TEST_CASE("should print time points and durations in containers to a string") {
+    constexpr auto format = JsonPrint::compile("[?, ?]");
+    std::vector<std::vector<milliseconds>> durations = { { milliseconds(1) }, { milliseconds(-2500) } };
+    std::map<std::string, system_clock::time_point> times = { { "t", from_milliseconds(1700000000123) } };
+    std::string result;
+    JsonPrint::detail::json_print(&result, format, durations, times);
+    CHECK(result == R"([[["PT0.001S"],["-PT2.500S"]], {"t":"2023-11-14T22:13:20.123Z"}])");
+}
+
+TEST_CASE("should not allow time points outside of four digit years") {
+    char buffer[128] = { 0 };
+    // nanosecond time points don't reach that far, so these are in milliseconds
+    using time = time_point<system_clock, milliseconds>;
+    CHECK_THROWS(json_sprint_c(buffer, sizeof(buffer), "?", time(milliseconds(253402300800000))));
+    CHECK_THROWS(json_sprint_c(buffer, sizeof(buffer), "?", time(milliseconds(-62167219200001))));
+    json_sprint_c(buffer, sizeof(buffer), "[?, ?]", time(milliseconds(253402300799999)), time(milliseconds(-62167219200000)));
+    CHECK(std::string(buffer) == R"(["9999-12-31T23:59:59.999Z", "0000-01-01T00:00:00.000Z"])");
+}
+
+TEST_CASE("should not allow an incomplete milliseconds specifier") {
+    CHECK_THROWS(JsonPrint::compile("[?{m}]"));
+    CHECK_THROWS(JsonPrint::compile("[?{.2ms}]"));
+}
@@ -0,0 +1,68 @@
+#define JP_COMPACT
+#include "doctest/doctest.h"
+#include "../src/json_print.hpp"
+#include "../src/json_print_chrono.hpp"
+#include "../src/json_print_compact.hpp"
+#include <chrono>
+
+TEST_CASE("should print literals in compact mode") {
+    char buffer[128] = { 0 };
+    constexpr auto context = JsonPrint::compile(R"({"hello": "world"})");
+    JsonPrint::json_sprint(buffer, sizeof(buffer), context);
+    CHECK(std::string(buffer) == R"({"hello": "world"})");
+}
+
+TEST_CASE("should print numbers in compact mode") {
+    char buffer[128] = { 0 };
+    json_sprint_c(buffer, sizeof(buffer), "[?, ?, ?, ?, ?, ?, ?, ?]", 
+        -42, 42u, -3000000000LL, 18446744073709551615ULL, (unsigned char)200, 1.5, 2.5f, std::nan(""));
+    CHECK(std::string(buffer) == "[-42, 42, -3000000000, 18446744073709551615, 200, 1.5, 2.5, null]");
+}
+
+TEST_CASE("should print numbers longer than 128 characters in compact mode") {
+    char expected[256];
+    snprintf(expected, sizeof(expected), "[%.99f]", 1e30);
+    char buffer[256] = { 0 };
+    json_sprint_c(buffer, sizeof(buffer), "[?{.99f}]", 1e30);
+    CHECK(std::string(buffer) == expected);
+}
+
+TEST_CASE("should print strings, booleans and null in compact mode") {
+    char buffer[128] = { 0 };
+    std::string text = "a\"b";
+    json_sprint_c(buffer, sizeof(buffer), "[?, ?, ?, ?, ?, ?]", "text", text, std::string_view("view"), 'c', true, nullptr);
+    CHECK(std::string(buffer) == R"(["text", "a\"b", "view", "c", true, null])");
+}
+
+TEST_CASE("should print specifiers in compact mode") {
+    char buffer[128] = { 0 };
+    json_sprint_c(buffer, sizeof(buffer), "[?{.2f}, ?{x}, ?{X}, ?{x}, ?{.3e}]", 1.0 / 3, int8_t(-1), 48879u, -1LL, 1234);
+    CHECK(std::string(buffer) == R"([0.33, "ff", "BEEF", "ffffffffffffffff", 1.234e+03])");
+}
+
+TEST_CASE("should print containers and templates in compact mode") {
+    char buffer[128] = { 0 };
+    constexpr auto inner = JsonPrint::compile("[?]");
+    std::map<std::string, std::vector<int>> values = { { "a", { 1, 2 } } };
+    json_sprint_c(buffer, sizeof(buffer), R"({"values": ?, "inner": ?})", values, JsonPrint::json_template(inner, "x"));
+    CHECK(std::string(buffer) == R"({"values": {"a":[1,2]}, "inner": ["x"]})");
+}
+
+TEST_CASE("should print times in compact mode") {
+    char buffer[128] = { 0 };
+    auto time = std::chrono::system_clock::time_point(std::chrono::milliseconds(1700000000123));
+    json_sprint_c(buffer, sizeof(buffer), "[?, ?{ms}]", time, time);
+    CHECK(std::string(buffer) == R"(["2023-11-14T22:13:20.123Z", 1700000000123])");
+}
+
+TEST_CASE("should truncate output in compact mode") {
+    char buffer[8] = { 0 };
+    json_sprint_c(buffer, sizeof(buffer), "[?, ?]", "hello", 12345);
+    CHECK(std::string(buffer) == R"(["hello)");
+}
+
+TEST_CASE("should use the compact printing functions in this translation unit") {
+    void (*compact)(FILE*, const JsonPrint::json_print_context&, int&&) = &JsonPrint::compact::json_fprint<int>;
+    void (*selected)(FILE*, const JsonPrint::json_print_context&, int&&) = &JsonPrint::json_fprint<int>;
+    CHECK(compact == selected);
+}
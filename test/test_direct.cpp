@@ -0,0 +1,57 @@
+#include "doctest/doctest.h"
+#include "../src/json_print.hpp"
+#include "../src/json_print_direct.hpp"
+#include <fstream>
+#include <sstream>
+
+static std::string read_file(const char* path) {
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream data;
+    data << file.rdbuf();
+    return data.str();
+}
+
+static std::string file_name(const char* test) {
+    return "json_print_test_direct_" + std::to_string(getpid()) + "_" + test + ".json";
+}
+
+TEST_CASE("should write an unaligned tail to a direct file") {
+    std::string path = file_name("tail");
+    {
+        JsonPrint::json_direct_writer writer(path.c_str());
+        json_direct_print_c(writer, R"({"id": ?, "name": ?})", 1, "first");
+        json_direct_print_c(writer, "[?]", std::vector<double> { 1.5, 2.5 });
+    }
+    CHECK(read_file(path.c_str()) == R"({"id": 1, "name": "first"}[[1.5,2.5]])");
+    remove(path.c_str());
+}
+
+TEST_CASE("should write records across many blocks") {
+    std::string path = file_name("blocks");
+    JsonPrint::json_direct_options options;
+    options.buffer_size = 4096;
+    std::string expected;
+    JsonPrint::json_direct_writer writer(path.c_str(), options);
+    constexpr auto context = JsonPrint::compile("{\"i\": ?, \"text\": ?}\n");
+    for (int i = 0; i < 10000; i++) {
+        std::string text(i % 50, 'a' + i % 26);
+        JsonPrint::json_direct_print(writer, context, i, text);
+        expected += "{\"i\": " + std::to_string(i) + ", \"text\": \"" + text + "\"}\n";
+    }
+    writer.close();
+    CHECK(read_file(path.c_str()) == expected);
+    remove(path.c_str());
+}
+
+TEST_CASE("should write an empty file") {
+    std::string path = file_name("empty");
+    JsonPrint::json_direct_writer writer(path.c_str());
+    writer.close();
+    writer.close();
+    CHECK(read_file(path.c_str()).empty());
+    remove(path.c_str());
+}
+
+TEST_CASE("should throw if the file can't be opened") {
+    CHECK_THROWS(JsonPrint::json_direct_writer("/nonexistent/directory/file.json"));
+}
@@ -0,0 +1,42 @@
+#include "doctest/doctest.h"
+#include "../src/json_print.hpp"
+#include "../src/json_print_document.hpp"
+
+TEST_CASE("should render placeholders in padded slots") {
+    constexpr auto context = JsonPrint::compile(R"({"requests": ?, "load": ?, "status": ?})");
+    JsonPrint::json_document document(context, 8, 12, 0.5, "ok");
+    CHECK(document.str() == R"({"requests": 12      , "load": 0.5     , "status": "ok"    })");
+    CHECK(document.size() == document.str().size());
+    CHECK(document.slot(0) == 13);
+}
+
+TEST_CASE("should update a placeholder in place") {
+    constexpr auto context = JsonPrint::compile(R"({"requests": ?, "status": ?})");
+    JsonPrint::json_document document(context, 8, 12, "ok");
+    const char* data = document.data();
+    document.set(0, 123456);
+    document.set(1, "busy");
+    CHECK(document.str() == R"({"requests": 123456  , "status": "busy"  })");
+    document.set(0, 1);
+    CHECK(document.str() == R"({"requests": 1       , "status": "busy"  })");
+    CHECK(document.data() == data);
+}
+
+TEST_CASE("should keep placeholder specifiers when updating") {
+    constexpr auto context = JsonPrint::compile("[?{.2f}, ?{x}]");
+    JsonPrint::json_document document(context, 10, 1.0, 255);
+    CHECK(document.str() == R"([1.00      , "ff"      ])");
+    document.set(0, 3.14159);
+    document.set(1, 4096);
+    CHECK(document.str() == R"([3.14      , "1000"    ])");
+}
+
+TEST_CASE("should reject values that don't fit their slot") {
+    constexpr auto context = JsonPrint::compile("[?]");
+    JsonPrint::json_document document(context, 4, 1);
+    CHECK_THROWS(document.set(0, 123456));
+    CHECK(document.str() == "[1   ]");
+    CHECK_THROWS(document.set(1, 1));
+    CHECK_THROWS(JsonPrint::json_document(context, 2, "long"));
+    CHECK_THROWS(JsonPrint::json_document(context, 4));
+}
@@ -101,4 +101,9 @@ TEST_CASE("should not allow balanced but invalid nesting") {
     char buffer[128] = { 0 };
     const char format[] = R"([{"a": 42]})";
     CHECK_THROWS(JsonPrint::compile(format, format + sizeof(format)));
-}
\ No newline at end of file
+}
+TEST_CASE("should not allow misspelled literals") {
+    const char* invalid[] = { "nope", "trux", "falsy", "[nul]" };
+    for (const char* format : invalid)
+        CHECK_THROWS(JsonPrint::compile(format, format + strlen(format)));
+}
@@ -0,0 +1,109 @@
+#include "doctest/doctest.h"
+#include "../src/json_print.hpp"
+#include "../src/json_print_fd.hpp"
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <thread>
+
+static std::string read_all(int fd) {
+    std::string data;
+    char buffer[4096];
+    for (ssize_t size; (size = read(fd, buffer, sizeof(buffer))) > 0;)
+        data.append(buffer, size);
+    return data;
+}
+
+TEST_CASE("should write records to a file descriptor when flushed") {
+    FILE* file = tmpfile();
+    {
+        JsonPrint::json_fd_writer writer(fileno(file));
+        json_fdprint_c(writer, R"({"id": ?, "name": ?})", 1, "first");
+        CHECK(writer.written() == 0);
+        writer.flush();
+        CHECK(writer.written() == 26);
+        json_fdprint_c(writer, "[?]", std::vector<double> { 1.5, 2.5 });
+    }
+    lseek(fileno(file), 0, SEEK_SET);
+    CHECK(read_all(fileno(file)) == R"({"id": 1, "name": "first"}[[1.5,2.5]])");
+    fclose(file);
+}
+
+TEST_CASE("should flush after every record") {
+    int fds[2];
+    REQUIRE(pipe(fds) == 0);
+    JsonPrint::json_fd_options options;
+    options.flush = JsonPrint::json_fd_flush_record;
+    JsonPrint::json_fd_writer writer(fds[1], options);
+    json_fdprint_c(writer, "[?, ?]\n", 1, true);
+
+    char buffer[64];
+    ssize_t size = read(fds[0], buffer, sizeof(buffer));
+    CHECK(std::string(buffer, size > 0 ? size : 0) == "[1, true]\n");
+    close(fds[0]);
+    close(fds[1]);
+}
+
+TEST_CASE("should write strings longer than the buffer") {
+    FILE* file = tmpfile();
+    JsonPrint::json_fd_options options;
+    options.buffer_size = 128;
+    std::string expected;
+    {
+        JsonPrint::json_fd_writer writer(fileno(file), options);
+        for (int i = 0; i < 100; i++) {
+            std::string text(i * 7, 'a' + i % 26);
+            json_fdprint_c(writer, R"({"i": ?, "text": ?})", i, text);
+            expected += R"({"i": )" + std::to_string(i) + R"(, "text": ")" + text + "\"}";
+        }
+        writer.flush();
+        CHECK(writer.written() == expected.size());
+    }
+    lseek(fileno(file), 0, SEEK_SET);
+    CHECK(read_all(fileno(file)) == expected);
+    fclose(file);
+}
+
+TEST_CASE("should retry partial writes to a non-blocking socket") {
+    int fds[2];
+    REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    int size = 4096;
+    setsockopt(fds[1], SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+    fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL) | O_NONBLOCK);
+
+    std::string received;
+    std::thread reader([&]() { received = read_all(fds[0]); });
+    std::string expected;
+    {
+        JsonPrint::json_fd_writer writer(fds[1]);
+        std::string text(100000, 'x');
+        for (int i = 0; i < 20; i++) {
+            json_fdprint_c(writer, "[?, ?]\n", i, text);
+            expected += "[" + std::to_string(i) + ", \"" + text + "\"]\n";
+        }
+    }
+    close(fds[1]);
+    reader.join();
+    close(fds[0]);
+    CHECK(received.size() == expected.size());
+    CHECK(received == expected);
+}
+
+TEST_CASE("should write numbers longer than 128 characters") {
+    FILE* file = tmpfile();
+    {
+        JsonPrint::json_fd_writer writer(fileno(file));
+        json_fdprint_c(writer, "[?{.99f}]", 1e30);
+    }
+    char expected[256];
+    snprintf(expected, sizeof(expected), "[%.99f]", 1e30);
+    lseek(fileno(file), 0, SEEK_SET);
+    CHECK(read_all(fileno(file)) == expected);
+    fclose(file);
+}
+
+TEST_CASE("should throw when the file descriptor can't be written") {
+    JsonPrint::json_fd_options options;
+    options.flush = JsonPrint::json_fd_flush_record;
+    JsonPrint::json_fd_writer writer(-1, options);
+    CHECK_THROWS(json_fdprint_c(writer, "[?]", 1));
+}
@@ -0,0 +1,100 @@
+#include "doctest/doctest.h"
+#include "../src/json_print.hpp"
+#include <sstream>
+#include <iterator>
+
+TEST_CASE("should print an iterator range") {
+    char buffer[128] = { 0 };
+    const char format[] = "?";
+    std::vector<int> data = { 24, 42, 7 };
+    JsonPrint::json_print_context context = JsonPrint::compile(format, format + sizeof(format));
+    json_sprint(buffer, sizeof(buffer), context, JsonPrint::json_range(data.begin() + 1, data.end()));
+    CHECK(std::string(buffer) == "[42,7]");
+}
+
+TEST_CASE("should print an input iterator range") {
+    char buffer[128] = { 0 };
+    const char format[] = "?";
+    std::istringstream input("1 2 3");
+    JsonPrint::json_print_context context = JsonPrint::compile(format, format + sizeof(format));
+    json_sprint(buffer, sizeof(buffer), context, 
+        JsonPrint::json_range(std::istream_iterator<int>(input), std::istream_iterator<int>()));
+    CHECK(std::string(buffer) == "[1,2,3]");
+}
+
+TEST_CASE("should print an empty generator") {
+    char buffer[128] = { 0 };
+    const char format[] = "?";
+    JsonPrint::json_print_context context = JsonPrint::compile(format, format + sizeof(format));
+    json_sprint(buffer, sizeof(buffer), context, JsonPrint::json_generator([](auto) {}));
+    CHECK(std::string(buffer) == "[]");
+}
+
+TEST_CASE("should print a generator of strings") {
+    char buffer[128] = { 0 };
+    const char format[] = R"({"names": ?})";
+    JsonPrint::json_print_context context = JsonPrint::compile(format, format + sizeof(format));
+    json_sprint(buffer, sizeof(buffer), context, JsonPrint::json_generator([](auto emit) {
+        emit("a");
+        emit(std::string("b"));
+    }));
+    CHECK(std::string(buffer) == R"({"names": ["a","b"]})");
+}
+
+TEST_CASE("should print a generator of arrays") {
+    char buffer[128] = { 0 };
+    const char format[] = "?";
+    JsonPrint::json_print_context context = JsonPrint::compile(format, format + sizeof(format));
+    json_sprint(buffer, sizeof(buffer), context, JsonPrint::json_generator([](auto emit) {
+        for (int i = 0; i < 3; i++)
+            emit(std::vector<int>(i, i));
+    }));
+    CHECK(std::string(buffer) == "[[],[1],[2,2]]");
+}
+
+TEST_CASE("should print millions of generated elements") {
+    const size_t count = 5000000;
+    std::vector<char> buffer(2 * count + 2, 0);
+    const char format[] = "?";
+    JsonPrint::json_print_context context = JsonPrint::compile(format, format + sizeof(format));
+    json_sprint(buffer.data(), buffer.size(), context, JsonPrint::json_generator([&](auto emit) {
+        for (size_t i = 0; i < count; i++)
+            emit(static_cast<int>(i % 10));
+    }));
+    std::string result(buffer.data());
+    REQUIRE(result.size() == 2 * count + 1);
+    CHECK(result.front() == '[');
+    CHECK(result.back() == ']');
+    CHECK(result.compare(0, 8, "[0,1,2,3") == 0);
+    CHECK(std::count(result.begin(), result.end(), ',') == count - 1);
+}
+
+namespace {
+
+/** Input iterator over 0, 1, 0, 1, ... without a container behind it */
+struct counter {
+    using iterator_category = std::input_iterator_tag;
+    using value_type = int;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const int*;
+    using reference = int;
+    int n;
+    int operator*() const { return n % 2; }
+    counter& operator++() { n++; return *this; }
+    counter operator++(int) { counter c = *this; n++; return c; }
+    bool operator!=(const counter& other) const { return n != other.n; }
+};
+
+}
+
+TEST_CASE("should print millions of elements from a counting range") {
+    const int count = 3000000;
+    std::vector<char> buffer(2 * count + 2, 0);
+    const char format[] = "?";
+    JsonPrint::json_print_context context = JsonPrint::compile(format, format + sizeof(format));
+    json_sprint(buffer.data(), buffer.size(), context, JsonPrint::json_range(counter { 0 }, counter { count }));
+    std::string result(buffer.data());
+    REQUIRE(result.size() == 2 * count + 1);
+    CHECK(result.compare(result.size() - 5, 5, ",0,1]") == 0);
+    CHECK(std::count(result.begin(), result.end(), '1') == count / 2);
+}
@@ -0,0 +1,125 @@
+#include "doctest/doctest.h"
+#include "../src/json_print.hpp"
+#include "../src/json_print_parallel.hpp"
+#include <thread>
+
+template <typename... Ts>
+static std::string print_to_string(const JsonPrint::json_print_context& context, const Ts&... args) {
+    std::string result;
+    JsonPrint::detail::json_print(&result, context, args...);
+    return result;
+}
+
+TEST_CASE("should print a small container serially") {
+    JsonPrint::json_worker_pool pool(4);
+    constexpr auto context = JsonPrint::compile("?");
+    std::vector<int> data = { 1, 2, 3 };
+    JsonPrint::json_parallel_options options;
+    options.pool = &pool;
+    CHECK(print_to_string(context, JsonPrint::json_parallel(data, options)) == "[1,2,3]");
+}
+
+TEST_CASE("should print a large vector in parallel chunks") {
+    JsonPrint::json_worker_pool pool(4);
+    constexpr auto context = JsonPrint::compile(R"({"values": ?})");
+    std::vector<int> data(100003);
+    for (size_t i = 0; i < data.size(); i++)
+        data[i] = static_cast<int>(i);
+    JsonPrint::json_parallel_options options;
+    options.threshold = 10;
+    options.chunk_size = 1000;
+    options.pool = &pool;
+    CHECK(print_to_string(context, JsonPrint::json_parallel(data, options)) == print_to_string(context, data));
+}
+
+TEST_CASE("should print a chunk size larger than the container") {
+    JsonPrint::json_worker_pool pool(2);
+    constexpr auto context = JsonPrint::compile("?");
+    std::vector<std::string> data = { "a", "b\n", "c" };
+    JsonPrint::json_parallel_options options;
+    options.threshold = 0;
+    options.pool = &pool;
+    CHECK(print_to_string(context, JsonPrint::json_parallel(data, options)) == R"(["a","b\n","c"])");
+}
+
+TEST_CASE("should print an empty container") {
+    JsonPrint::json_worker_pool pool(2);
+    constexpr auto context = JsonPrint::compile("?");
+    std::vector<int> data;
+    JsonPrint::json_parallel_options options;
+    options.threshold = 0;
+    options.pool = &pool;
+    CHECK(print_to_string(context, JsonPrint::json_parallel(data, options)) == "[]");
+}
+
+TEST_CASE("should print a large unordered_map as an object in parallel") {
+    JsonPrint::json_worker_pool pool(3);
+    constexpr auto context = JsonPrint::compile("?");
+    std::unordered_map<std::string, int> data;
+    for (int i = 0; i < 5000; i++)
+        data["key" + std::to_string(i)] = i;
+    JsonPrint::json_parallel_options options;
+    options.threshold = 100;
+    options.chunk_size = 77;
+    options.pool = &pool;
+    CHECK(print_to_string(context, JsonPrint::json_parallel(data, options)) == print_to_string(context, data));
+}
+
+TEST_CASE("should reuse a pool across many prints") {
+    JsonPrint::json_worker_pool pool(4);
+    constexpr auto context = JsonPrint::compile("?");
+    std::vector<double> data(1000, 0.5);
+    std::string expected = print_to_string(context, data);
+    JsonPrint::json_parallel_options options;
+    options.threshold = 0;
+    options.chunk_size = 10;
+    options.pool = &pool;
+    for (int i = 0; i < 200; i++)
+        CHECK(print_to_string(context, JsonPrint::json_parallel(data, options)) == expected);
+}
+
+TEST_CASE("should print from two threads sharing a pool") {
+    JsonPrint::json_worker_pool pool(4);
+    constexpr auto context = JsonPrint::compile("?");
+    std::vector<int> first(5000, 1);
+    std::vector<int> second(7000, 2);
+    std::string expected_first = print_to_string(context, first);
+    std::string expected_second = print_to_string(context, second);
+    JsonPrint::json_parallel_options options;
+    options.threshold = 0;
+    options.chunk_size = 100;
+    options.pool = &pool;
+    int mismatches[2] = { 0, 0 };
+    std::thread other([&]() {
+        for (int i = 0; i < 100; i++)
+            mismatches[1] += print_to_string(context, JsonPrint::json_parallel(second, options)) != expected_second;
+    });
+    for (int i = 0; i < 100; i++)
+        mismatches[0] += print_to_string(context, JsonPrint::json_parallel(first, options)) != expected_first;
+    other.join();
+    CHECK(mismatches[0] == 0);
+    CHECK(mismatches[1] == 0);
+}
+
+TEST_CASE("should run a batch started by a task on the task's thread") {
+    JsonPrint::json_worker_pool pool(3);
+    std::vector<std::atomic<int>> calls(4 * 5);
+    pool.run(4, [&](size_t i) {
+        pool.run(5, [&](size_t j) { calls[i * 5 + j]++; });
+    });
+    for (std::atomic<int>& count : calls)
+        CHECK(count == 1);
+
+    constexpr auto context = JsonPrint::compile("?");
+    std::vector<int> data(1000, 3);
+    JsonPrint::json_parallel_options options;
+    options.threshold = 0;
+    options.chunk_size = 10;
+    options.pool = &pool;
+    std::vector<std::string> printed(4);
+    pool.run(printed.size(), [&](size_t i) {
+        printed[i] = print_to_string(context, JsonPrint::json_parallel(data, options));
+    });
+    for (const std::string& text : printed)
+        CHECK(text == print_to_string(context, data));
+}
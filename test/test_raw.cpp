@@ -0,0 +1,66 @@
+#include "doctest/doctest.h"
+#include "../src/json_print.hpp"
+#include <memory>
+#include <string>
+
+TEST_CASE("should copy raw JSON into the output as it is") {
+    char buffer[128] = { 0 };
+    std::string cached = R"({"id": 7, "tags": ["a", "b"]})";
+    json_sprint_c(buffer, sizeof(buffer), R"({"user": ?, "n": ?})", JsonPrint::json_raw(cached), 1);
+    CHECK(std::string(buffer) == R"({"user": {"id": 7, "tags": ["a", "b"]}, "n": 1})");
+
+    json_sprint_c(buffer, sizeof(buffer), "[?, ?]", JsonPrint::json_raw("true"), JsonPrint::json_raw(cached.data(), cached.data() + 8));
+    CHECK(std::string(buffer) == R"([true, {"id": 7])");
+}
+
+TEST_CASE("should print vectors of raw JSON") {
+    char buffer[128] = { 0 };
+    std::vector<JsonPrint::detail::json_raw_arg> fragments = { JsonPrint::json_raw("1"), JsonPrint::json_raw(R"({"a":null})") };
+    json_sprint_c(buffer, sizeof(buffer), "?", fragments);
+    CHECK(std::string(buffer) == R"([1,{"a":null}])");
+}
+
+TEST_CASE("should validate raw JSON when asked to") {
+    char buffer[128] = { 0 };
+    json_sprint_c(buffer, sizeof(buffer), "?", JsonPrint::json_raw_validated(R"( [1, "x", {"b": false}] )"));
+    CHECK(std::string(buffer) == R"( [1, "x", {"b": false}] )");
+
+    const char* invalid[] = { "", " ", "[1,", R"({"a" 1})", R"("abc)", "tru", "1 2", "?", "[1, ?]", R"({...?})", "[1]]" };
+    for (const char* text : invalid)
+        CHECK_THROWS(JsonPrint::json_raw_validated(text));
+}
+
+TEST_CASE("should reject misspelled literals in raw JSON") {
+    const char* invalid[] = { "nope", "trux", "falsy", "nul", "[nulL]", R"({"a": fals})" };
+    for (const char* text : invalid)
+        CHECK_THROWS(JsonPrint::json_raw_validated(text));
+    JsonPrint::json_raw_validated("[null, true, false]");
+}
+
+TEST_CASE("should validate raw JSON that isn't null-terminated") {
+    // copied into exactly-sized heap buffers, so reading past the end is caught by sanitizers
+    const char* invalid[] = { "[tr", R"({"a":)", "[", "n", "fals", "[1,", R"({"a")", "-" };
+    for (const char* text : invalid) {
+        size_t size = strlen(text);
+        std::unique_ptr<char[]> copy(new char[size]);
+        memcpy(copy.get(), text, size);
+        CHECK_THROWS(JsonPrint::json_raw_validated(copy.get(), copy.get() + size));
+    }
+    const char* valid[] = { "true", "[null]", R"({"a":false})", "1" };
+    for (const char* text : valid) {
+        size_t size = strlen(text);
+        std::unique_ptr<char[]> copy(new char[size]);
+        memcpy(copy.get(), text, size);
+        JsonPrint::json_raw_validated(copy.get(), copy.get() + size);
+    }
+}
+
+TEST_CASE("should limit the nesting of validated raw JSON") {
+    std::string nested = std::string(100, '[') + std::string(100, ']');
+    JsonPrint::json_raw_validated(nested);
+    CHECK_THROWS(JsonPrint::json_raw_validated(std::string(1000000, '[')));
+    std::string objects;
+    for (int i = 0; i < 100000; i++)
+        objects += R"({"a":)";
+    CHECK_THROWS(JsonPrint::json_raw_validated(objects));
+}
@@ -0,0 +1,105 @@
+#include "doctest/doctest.h"
+#include "../src/json_print.hpp"
+#include "../src/json_print_registry.hpp"
+#include <thread>
+
+TEST_CASE("should register and print a run-time template") {
+    char buffer[128] = { 0 };
+    JsonPrint::json_template_registry registry;
+    const JsonPrint::json_registered_template& handle = registry.add("greeting", std::string(R"({"hello": ?})"));
+    CHECK(handle.id == 0);
+    CHECK(std::string(handle.name) == "greeting");
+    json_sprint(buffer, sizeof(buffer), handle, "world");
+    CHECK(std::string(buffer) == R"({"hello": "world"})");
+}
+
+TEST_CASE("should keep its own copy of the template text") {
+    char buffer[128] = { 0 };
+    JsonPrint::json_template_registry registry;
+    {
+        std::string format = "[?, ?]";
+        registry.add("pair", format);
+        format.assign("xxxxxx");
+    }
+    json_sprint(buffer, sizeof(buffer), *registry.find("pair"), 1, 2);
+    CHECK(std::string(buffer) == "[1, 2]");
+}
+
+TEST_CASE("should find templates by name and id") {
+    JsonPrint::json_template_registry registry;
+    registry.add("a", std::string("1"));
+    const JsonPrint::json_registered_template& b = registry.add("b", std::string("[?]"));
+    CHECK(registry.size() == 2);
+    CHECK(registry.find("b") == &b);
+    CHECK(registry.find(size_t(1)) == &b);
+    CHECK(registry.find("c") == nullptr);
+    CHECK(registry.find(size_t(2)) == nullptr);
+}
+
+TEST_CASE("should find templates by any kind of name") {
+    JsonPrint::json_template_registry registry;
+    const JsonPrint::json_registered_template& entry = registry.add("entry", std::string("[?]"));
+    const char name[] = "entry";
+    const char* prefix = "entry.log";
+    CHECK(registry.find(name) == &entry);
+    CHECK(registry.find(std::string(name)) == &entry);
+    CHECK(registry.find(std::string_view(prefix, 5)) == &entry);
+    CHECK(registry.find(std::string_view(prefix, 4)) == nullptr);
+    CHECK(registry.find("") == nullptr);
+}
+
+TEST_CASE("should reject invalid templates and duplicate names") {
+    JsonPrint::json_template_registry registry;
+    CHECK_THROWS(registry.add("bad", std::string("{hello: ?}")));
+    CHECK(registry.find("bad") == nullptr);
+    CHECK(registry.size() == 0);
+    registry.add("good", std::string("?"));
+    CHECK_THROWS(registry.add("good", std::string("[]")));
+}
+
+TEST_CASE("should not keep the text of invalid templates") {
+    JsonPrint::json_template_registry registry;
+    const JsonPrint::json_registered_template& first = registry.add("first", std::string("[?]"));
+    for (int i = 0; i < 10000; i++)
+        CHECK_THROWS(registry.add("bad", std::string("{hello: ?}")));
+    const JsonPrint::json_registered_template& second = registry.add("second", std::string("{\"a\": ?}"));
+    // the first template's text is followed by its name
+    CHECK(first.name == first.context.parts[0] + 3);
+    CHECK(second.context.parts[0] == first.name + sizeof("first"));
+    char buffer[32] = { 0 };
+    json_sprint(buffer, sizeof(buffer), second, 1);
+    CHECK(std::string(buffer) == R"({"a": 1})");
+}
+
+TEST_CASE("should keep handles stable while templates are added") {
+    JsonPrint::json_template_registry registry;
+    const JsonPrint::json_registered_template& first = registry.add("first", std::string("[?]"));
+    std::string long_template(10000, ' ');
+    long_template[5000] = '?';
+    for (int i = 0; i < 1000; i++)
+        registry.add("t" + std::to_string(i), i % 100 == 0 ? long_template : std::string("{\"i\": ?}"));
+    char buffer[128] = { 0 };
+    json_sprint(buffer, sizeof(buffer), first, 42);
+    CHECK(std::string(buffer) == "[42]");
+    CHECK(registry.find("first") == &first);
+}
+
+TEST_CASE("should allow lookups while templates are added") {
+    JsonPrint::json_template_registry registry;
+    registry.add("base", std::string("[?]"));
+    std::thread writer([&]() {
+        for (int i = 0; i < 2000; i++)
+            registry.add("t" + std::to_string(i), std::string("{\"i\": ?}"));
+    });
+    bool all_found = true;
+    for (int i = 0; i < 2000; i++) {
+        char buffer[32] = { 0 };
+        const JsonPrint::json_registered_template* base = registry.find("base");
+        all_found = all_found && base != nullptr;
+        json_sprint(buffer, sizeof(buffer), *base, i);
+        all_found = all_found && std::string(buffer) == "[" + std::to_string(i) + "]";
+    }
+    writer.join();
+    CHECK(all_found);
+    CHECK(registry.size() == 2001);
+}
@@ -0,0 +1,161 @@
+#include "doctest/doctest.h"
+#include "../src/json_print.hpp"
+#include "../src/json_print_resumable.hpp"
+#include <iterator>
+#include <sstream>
+
+template <typename T>
+static std::string write_all(T& print, size_t size) {
+    std::string result;
+    std::vector<char> buffer(size);
+    size_t written = 0;
+    JsonPrint::json_print_status status = JsonPrint::json_print_pending;
+    while (status == JsonPrint::json_print_pending) {
+        status = print.write(buffer.data(), buffer.size(), &written);
+        CHECK(written <= size);
+        result.append(buffer.data(), written);
+    }
+    return result;
+}
+
+TEST_CASE("should write a resumable print into one large buffer") {
+    const char format[] = R"({"a": ?, "b": ?})";
+    JsonPrint::json_print_context context = JsonPrint::compile(format, format + sizeof(format));
+    auto print = JsonPrint::json_print_resumable(context, 42, "hello");
+    CHECK(write_all(print, 128) == R"({"a": 42, "b": "hello"})");
+    CHECK(!print.pending());
+}
+
+TEST_CASE("should report pending text when the buffer is full") {
+    const char format[] = "[?]";
+    JsonPrint::json_print_context context = JsonPrint::compile(format, format + sizeof(format));
+    auto print = JsonPrint::json_print_resumable(context, 12345);
+    char buffer[4];
+    size_t written = 0;
+    CHECK(print.write(buffer, sizeof(buffer), &written) == JsonPrint::json_print_pending);
+    CHECK(std::string(buffer, written) == "[123");
+    CHECK(print.write(buffer, sizeof(buffer), &written) == JsonPrint::json_print_done);
+    CHECK(std::string(buffer, written) == "45]");
+}
+
+TEST_CASE("should finish when the text exactly fills the buffer") {
+    const char format[] = "[?]";
+    JsonPrint::json_print_context context = JsonPrint::compile(format, format + sizeof(format));
+    auto print = JsonPrint::json_print_resumable(context, 1);
+    char buffer[3];
+    size_t written = 0;
+    CHECK(print.write(buffer, sizeof(buffer), &written) == JsonPrint::json_print_done);
+    CHECK(written == 3);
+}
+
+TEST_CASE("should resume mid-string, mid-number and mid-container for any buffer size") {
+    char expected[512] = { 0 };
+    const char format[] = R"({"text": ?, "number": ?, "values": ?, "map": ?, "inner": ?})";
+    const char inner_format[] = R"([?, "literal"])";
+    JsonPrint::json_print_context context = JsonPrint::compile(format, format + sizeof(format));
+    JsonPrint::json_print_context inner = JsonPrint::compile(inner_format, inner_format + sizeof(inner_format));
+    std::string text = "line\none \"quoted\" \\ tab\t";
+    std::vector<double> values = { 1.5, -2.25, 1e10 };
+    std::map<std::string, int> map = { { "x", 1 }, { "y\n", 2 } };
+    json_sprint(expected, sizeof(expected), context, text, 1234567890, values, map, JsonPrint::json_template(inner, text));
+
+    for (size_t size = 1; size <= 64; size++) {
+        auto print = JsonPrint::json_print_resumable(context, text, 1234567890, values, map, JsonPrint::json_template(inner, text));
+        CHECK(write_all(print, size) == expected);
+    }
+}
+
+TEST_CASE("should resume a generated array") {
+    char expected[512] = { 0 };
+    const char format[] = "?";
+    JsonPrint::json_print_context context = JsonPrint::compile(format, format + sizeof(format));
+    auto generator = JsonPrint::json_generator([](auto emit) {
+        for (int i = 0; i < 100; i++)
+            emit(i);
+    });
+    json_sprint(expected, sizeof(expected), context, generator);
+    auto print = JsonPrint::json_print_resumable(context, generator);
+    CHECK(write_all(print, 16) == expected);
+}
+
+TEST_CASE("should call a generator once per element across many buffers") {
+    const char format[] = "?";
+    JsonPrint::json_print_context context = JsonPrint::compile(format, format + sizeof(format));
+    int calls = 0;
+    auto generator = JsonPrint::json_generator([&](auto emit) {
+        for (int i = 0; i < 1000; i++) {
+            calls++;
+            emit(i);
+        }
+    });
+    auto print = JsonPrint::json_print_resumable(context, generator);
+    std::string output = write_all(print, 3);
+    CHECK(calls == 1000);
+    CHECK(output.size() == 3891);
+    CHECK(output.substr(0, 8) == "[0,1,2,3");
+}
+
+TEST_CASE("should read the elements of a range once, and only as far as the buffer") {
+    const char format[] = R"({"values": ?})";
+    JsonPrint::json_print_context context = JsonPrint::compile(format, format + sizeof(format));
+    std::string numbers;
+    for (int i = 0; i < 100; i++)
+        numbers += std::to_string(i) + " ";
+    std::istringstream input(numbers);
+    auto range = JsonPrint::json_range(std::istream_iterator<int>(input), std::istream_iterator<int>());
+    auto print = JsonPrint::json_print_resumable(context, range);
+
+    char buffer[16];
+    size_t written = 0;
+    CHECK(print.write(buffer, sizeof(buffer), &written) == JsonPrint::json_print_pending);
+    CHECK(std::string(buffer, written) == R"({"values": [0,1,)");
+    CHECK(input.tellg() < 10);
+
+    std::string expected = R"({"values": [0)";
+    for (int i = 1; i < 100; i++)
+        expected += "," + std::to_string(i);
+    CHECK(std::string(buffer, written) + write_all(print, 7) == expected + "]}");
+}
+
+TEST_CASE("should keep only a buffer's worth of text for nested containers, strings and sub-templates") {
+    const char format[] = R"({"rows": ?, "text": ?, "inner": ?, "raw": ?})";
+    const char inner_format[] = R"({"names": ?})";
+    JsonPrint::json_print_context context = JsonPrint::compile(format, format + sizeof(format));
+    JsonPrint::json_print_context inner = JsonPrint::compile(inner_format, inner_format + sizeof(inner_format));
+    std::vector<std::vector<int>> rows(100, std::vector<int>(100, 12345));
+    std::string text(100000, '\n');
+    std::map<std::string, std::string> names = { { "a", std::string(10000, 'x') }, { "b", "\xE2\x82\xAC" } };
+    std::string raw = "[" + std::string(10000, ' ') + "]";
+    std::vector<char> expected(1 << 20);
+    json_sprint(expected.data(), expected.size(), context, rows, text, JsonPrint::json_template(inner, names), JsonPrint::json_raw(raw));
+
+    for (size_t size : { 1, 7, 64 }) {
+        auto print = JsonPrint::json_print_resumable(context, rows, text, JsonPrint::json_template(inner, names), JsonPrint::json_raw(raw));
+        std::string result;
+        std::vector<char> buffer(size);
+        size_t written = 0;
+        size_t most_buffered = 0;
+        while (print.pending()) {
+            print.write(buffer.data(), buffer.size(), &written);
+            result.append(buffer.data(), written);
+            most_buffered = (std::max)(most_buffered, print.buffered());
+        }
+        CHECK(result == expected.data());
+        // an escaped "\n" is twice the size of the text it was escaped from
+        CHECK(most_buffered <= 2 * size + 8);
+    }
+}
+
+TEST_CASE("should limit the text kept for the next buffer") {
+    const char format[] = "?";
+    JsonPrint::json_print_context context = JsonPrint::compile(format, format + sizeof(format));
+    auto generator = JsonPrint::json_generator([](auto emit) {
+        for (int i = 0; i < 1000; i++)
+            emit(i);
+    });
+    auto print = JsonPrint::json_print_resumable(context, generator);
+    print.set_max_buffered(1000);
+    char buffer[16];
+    size_t written = 0;
+    CHECK_THROWS(print.write(buffer, sizeof(buffer), &written));
+}
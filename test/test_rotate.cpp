@@ -0,0 +1,96 @@
+#include "doctest/doctest.h"
+#include "../src/json_print.hpp"
+#include "../src/json_print_rotate.hpp"
+#include <fstream>
+#include <sstream>
+
+static std::string read_file(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream data;
+    data << file.rdbuf();
+    return data.str();
+}
+
+static bool exists(const std::string& path) {
+    struct stat status;
+    return stat(path.c_str(), &status) == 0;
+}
+
+/** Temporary directory, removed with its files when the test ends */
+struct temporary_directory {
+    std::string path;
+
+    temporary_directory() {
+        char name[] = "/tmp/json_print_test_rotate_XXXXXX";
+        REQUIRE(mkdtemp(name) != nullptr);
+        path = name;
+    }
+
+    ~temporary_directory() {
+        for (int i = 0; i < 100; i++)
+            remove((path + "/log." + std::to_string(i)).c_str());
+        rmdir(path.c_str());
+    }
+};
+
+TEST_CASE("should switch files after a number of records") {
+    temporary_directory directory;
+    std::string path = directory.path + "/log";
+    JsonPrint::json_rotate_options options;
+    options.max_records = 3;
+    {
+        JsonPrint::json_rotating_writer writer(path.c_str(), options);
+        for (int i = 0; i < 10; i++)
+            json_rotate_print_c(writer, "{\"i\": ?}\n", i);
+    }
+    CHECK(read_file(path + ".1") == "{\"i\": 0}\n{\"i\": 1}\n{\"i\": 2}\n");
+    CHECK(read_file(path + ".2") == "{\"i\": 3}\n{\"i\": 4}\n{\"i\": 5}\n");
+    CHECK(read_file(path + ".3") == "{\"i\": 6}\n{\"i\": 7}\n{\"i\": 8}\n");
+    CHECK(read_file(path + ".4") == "{\"i\": 9}\n");
+    CHECK_FALSE(exists(path + ".5"));
+    CHECK_FALSE(exists(path + ".5.tmp"));
+}
+
+TEST_CASE("should switch files between records at a size") {
+    temporary_directory directory;
+    std::string path = directory.path + "/log";
+    JsonPrint::json_rotate_options options;
+    options.max_size = 1000;
+    options.buffer_size = 128;
+    std::string expected;
+    {
+        JsonPrint::json_rotating_writer writer(path.c_str(), options);
+        for (int i = 0; i < 1000; i++) {
+            std::string text(i % 50, 'x');
+            json_rotate_print_c(writer, "[?, ?]\n", i, text);
+            expected += "[" + std::to_string(i) + ", \"" + text + "\"]\n";
+        }
+    }
+    std::string all;
+    int files = 0;
+    for (int i = 1; exists(path + "." + std::to_string(i)); i++, files++) {
+        std::string data = read_file(path + "." + std::to_string(i));
+        CHECK(data.back() == '\n');
+        CHECK(data.size() < 1000 + 60);
+        all += data;
+    }
+    CHECK(files > 10);
+    CHECK(all == expected);
+}
+
+TEST_CASE("should continue after the files of an earlier run") {
+    temporary_directory directory;
+    std::string path = directory.path + "/log";
+    JsonPrint::json_rotate_options options;
+    options.max_records = 1;
+    for (int run = 0; run < 2; run++) {
+        JsonPrint::json_rotating_writer writer(path.c_str(), options);
+        json_rotate_print_c(writer, "[?]", run);
+    }
+    CHECK(read_file(path + ".1") == "[0]");
+    CHECK(read_file(path + ".2") == "[1]");
+}
+
+TEST_CASE("should throw if the file can't be created") {
+    CHECK_THROWS(JsonPrint::json_rotating_writer("/nonexistent/directory/log"));
+}
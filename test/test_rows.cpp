@@ -0,0 +1,70 @@
+#include "doctest/doctest.h"
+#include "../src/json_print.hpp"
+#include "../src/json_print_rows.hpp"
+#include <cstdio>
+#include <list>
+#include <string>
+#include <vector>
+
+TEST_CASE("should print one row per element of the columns") {
+    char buffer[256] = { 0 };
+    std::vector<long long> ts = { 100, 200, 300 };
+    std::vector<double> values = { 0.5, 1.25, 2 };
+    std::list<std::string> tags = { "a", "b", "c" };
+    json_sprint_rows_c(buffer, sizeof(buffer), R"({"ts": ?, "v": ?{.1f}, "tag": ?})", ts, values, tags);
+    CHECK(std::string(buffer) ==
+        "{\"ts\": 100, \"v\": 0.5, \"tag\": \"a\"}\n"
+        "{\"ts\": 200, \"v\": 1.2, \"tag\": \"b\"}\n"
+        "{\"ts\": 300, \"v\": 2.0, \"tag\": \"c\"}\n");
+}
+
+TEST_CASE("should print rows of boolean and array columns") {
+    char buffer[128] = { 0 };
+    std::vector<bool> flags = { true, false };
+    std::array<int, 2> ids = { 1, 2 };
+    json_sprint_rows_c(buffer, sizeof(buffer), "[?, ?]", ids, flags);
+    CHECK(std::string(buffer) == "[1, true]\n[2, false]\n");
+
+    json_sprint_rows_c(buffer, sizeof(buffer), "?", std::vector<int> {});
+    CHECK(std::string(buffer) == "");
+}
+
+TEST_CASE("should check the columns before printing") {
+    char buffer[128] = { 0 };
+    std::vector<int> two = { 1, 2 };
+    std::vector<int> three = { 1, 2, 3 };
+    CHECK_THROWS(json_sprint_rows_c(buffer, sizeof(buffer), "[?, ?]", two, three));
+    CHECK(std::string(buffer) == "");
+    CHECK_THROWS(json_sprint_rows_c(buffer, sizeof(buffer), "[?, ?]", two));
+}
+
+TEST_CASE("should write rows to a file in batches") {
+    FILE* file = tmpfile();
+    REQUIRE(file != nullptr);
+    std::vector<int> ids(20000);
+    for (size_t i = 0; i < ids.size(); i++)
+        ids[i] = static_cast<int>(i);
+    json_fprint_rows_c(file, R"({"id": ?})", ids);
+    std::string expected;
+    for (int id : ids)
+        expected += "{\"id\": " + std::to_string(id) + "}\n";
+    std::string text(expected.size() + 1, '\0');
+    rewind(file);
+    text.resize(fread(&text[0], 1, text.size(), file));
+    fclose(file);
+    CHECK(text == expected);
+}
+
+TEST_CASE("should write numbers longer than 128 characters to a file") {
+    FILE* file = tmpfile();
+    REQUIRE(file != nullptr);
+    std::vector<double> values = { 1e30, 2.5 };
+    json_fprint_rows_c(file, "[?{.99f}]", values);
+    char expected[512];
+    snprintf(expected, sizeof(expected), "[%.99f]\n[%.99f]\n", 1e30, 2.5);
+    std::string text(sizeof(expected), '\0');
+    rewind(file);
+    text.resize(fread(&text[0], 1, text.size(), file));
+    fclose(file);
+    CHECK(text == expected);
+}
@@ -0,0 +1,164 @@
+#include "doctest/doctest.h"
+#include "../src/json_print.hpp"
+#include "../src/json_print_shm.hpp"
+#include <sys/wait.h>
+#include <thread>
+
+static std::string ring_name(const char* test) {
+    return "/json_print_test_" + std::to_string(getpid()) + "_" + test;
+}
+
+TEST_CASE("should read records written to a shared memory ring") {
+    std::string name = ring_name("basic");
+    JsonPrint::json_shm_ring ring = JsonPrint::json_shm_ring::create(name.c_str(), 4096);
+    JsonPrint::json_shm_ring::unlink(name.c_str());
+    JsonPrint::json_shm_writer writer(ring);
+    JsonPrint::json_shm_reader reader(ring);
+
+    CHECK(json_shm_print_c(writer, R"({"id": ?, "name": ?})", 1, "first"));
+    CHECK(json_shm_print_c(writer, "[?]", std::vector<int> { 1, 2 }));
+
+    std::string record;
+    REQUIRE(reader.read(record, 0));
+    CHECK(record == R"({"id": 1, "name": "first"})");
+    REQUIRE(reader.read(record, 0));
+    CHECK(record == "[[1,2]]");
+    CHECK_FALSE(reader.read(record, 0));
+}
+
+TEST_CASE("should open a ring by name") {
+    std::string name = ring_name("open");
+    JsonPrint::json_shm_ring created = JsonPrint::json_shm_ring::create(name.c_str(), 1024);
+    JsonPrint::json_shm_ring opened = JsonPrint::json_shm_ring::open(name.c_str());
+    JsonPrint::json_shm_ring::unlink(name.c_str());
+    CHECK(opened.capacity() == 1024);
+
+    JsonPrint::json_shm_writer writer(created);
+    JsonPrint::json_shm_reader reader(opened);
+    json_shm_print_c(writer, "[?]", "shared");
+    std::string record;
+    REQUIRE(reader.read(record, 0));
+    CHECK(record == R"(["shared"])");
+}
+
+TEST_CASE("should wrap records around the end of the ring") {
+    std::string name = ring_name("wrap");
+    JsonPrint::json_shm_ring ring = JsonPrint::json_shm_ring::create(name.c_str(), 256);
+    JsonPrint::json_shm_ring::unlink(name.c_str());
+    JsonPrint::json_shm_writer writer(ring);
+    JsonPrint::json_shm_reader reader(ring);
+
+    std::string record;
+    for (int i = 0; i < 100; i++) {
+        std::string text(i % 40, 'x');
+        REQUIRE(json_shm_print_c(writer, R"({"i": ?, "text": ?})", i, text));
+        REQUIRE(reader.read(record, 0));
+        CHECK(record == R"({"i": )" + std::to_string(i) + R"(, "text": ")" + text + "\"}");
+    }
+}
+
+TEST_CASE("should drop records when the ring is full and the writer doesn't block") {
+    std::string name = ring_name("full");
+    JsonPrint::json_shm_ring ring = JsonPrint::json_shm_ring::create(name.c_str(), 128);
+    JsonPrint::json_shm_ring::unlink(name.c_str());
+    JsonPrint::json_shm_options options;
+    options.block = false;
+    JsonPrint::json_shm_writer writer(ring, options);
+    JsonPrint::json_shm_reader reader(ring);
+
+    int written = 0;
+    for (int i = 0; i < 20; i++)
+        written += json_shm_print_c(writer, "[?, ?]", i, "0123456789");
+    CHECK(written < 20);
+    CHECK(writer.dropped() == static_cast<unsigned long long>(20 - written));
+
+    std::string record;
+    for (int i = 0; i < written; i++) {
+        REQUIRE(reader.read(record, 0));
+        CHECK(record == "[" + std::to_string(i) + R"(, "0123456789"])");
+    }
+    CHECK_FALSE(reader.read(record, 0));
+}
+
+TEST_CASE("should reject records larger than the ring") {
+    std::string name = ring_name("large");
+    JsonPrint::json_shm_ring ring = JsonPrint::json_shm_ring::create(name.c_str(), 128);
+    JsonPrint::json_shm_ring::unlink(name.c_str());
+    JsonPrint::json_shm_writer writer(ring);
+    CHECK_THROWS(json_shm_print_c(writer, "[?]", std::string(200, 'x')));
+}
+
+TEST_CASE("should release the producer lock after a record that is too large") {
+    std::string name = ring_name("large_multi");
+    JsonPrint::json_shm_ring ring = JsonPrint::json_shm_ring::create(name.c_str(), 128);
+    JsonPrint::json_shm_ring::unlink(name.c_str());
+    JsonPrint::json_shm_options options;
+    options.multi_producer = true;
+    JsonPrint::json_shm_writer first(ring, options);
+    JsonPrint::json_shm_writer second(ring, options);
+    JsonPrint::json_shm_reader reader(ring);
+    CHECK_THROWS(json_shm_print_c(first, "[?]", std::string(200, 'x')));
+
+    // would wait forever on the lock if it were still held
+    std::thread other([&]() { CHECK(json_shm_print_c(second, "[?]", 2)); });
+    other.join();
+    CHECK(json_shm_print_c(first, "[?]", 1));
+    std::string record;
+    REQUIRE(reader.read(record, 0));
+    CHECK(record == "[2]");
+    REQUIRE(reader.read(record, 0));
+    CHECK(record == "[1]");
+}
+
+TEST_CASE("should wake a waiting reader from another thread") {
+    std::string name = ring_name("thread");
+    JsonPrint::json_shm_ring ring = JsonPrint::json_shm_ring::create(name.c_str(), 1024);
+    JsonPrint::json_shm_ring::unlink(name.c_str());
+    JsonPrint::json_shm_writer writer(ring);
+    JsonPrint::json_shm_reader reader(ring);
+
+    const int count = 10000;
+    std::thread producer([&]() {
+        for (int i = 0; i < count; i++)
+            json_shm_print_c(writer, "[?]", i);
+    });
+    std::string record;
+    int received = 0;
+    bool ordered = true;
+    while (received < count && reader.read(record, 5000)) {
+        ordered = ordered && record == "[" + std::to_string(received) + "]";
+        received++;
+    }
+    producer.join();
+    CHECK(received == count);
+    CHECK(ordered);
+}
+
+TEST_CASE("should hand records to another process") {
+    std::string name = ring_name("process");
+    JsonPrint::json_shm_ring ring = JsonPrint::json_shm_ring::create(name.c_str(), 1024);
+    const int count = 1000;
+    pid_t child = fork();
+    if (child == 0) {
+        JsonPrint::json_shm_ring opened = JsonPrint::json_shm_ring::open(name.c_str());
+        JsonPrint::json_shm_options options;
+        options.multi_producer = true;
+        JsonPrint::json_shm_writer writer(opened, options);
+        for (int i = 0; i < count; i++)
+            json_shm_print_c(writer, R"({"child": ?})", i);
+        _exit(0);
+    }
+    JsonPrint::json_shm_reader reader(ring);
+    std::string record;
+    int received = 0;
+    while (received < count && reader.read(record, 5000)) {
+        if (record != R"({"child": )" + std::to_string(received) + "}")
+            break;
+        received++;
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
+    JsonPrint::json_shm_ring::unlink(name.c_str());
+    CHECK(received == count);
+    CHECK(WIFEXITED(status));
+}
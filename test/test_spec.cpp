@@ -0,0 +1,87 @@
+#include "doctest/doctest.h"
+#include "../src/json_print.hpp"
+#include "../src/json_print_resumable.hpp"
+
+TEST_CASE("should print fixed decimals with a specifier") {
+    char buffer[128] = { 0 };
+    json_sprint_c(buffer, sizeof(buffer), R"({"price": ?{.2f}, "total": ?{.0f}})", 9.5, 1234.5678);
+    CHECK(std::string(buffer) == R"({"price": 9.50, "total": 1235})");
+}
+
+TEST_CASE("should print exponents and significant digits with a specifier") {
+    char buffer[128] = { 0 };
+    json_sprint_c(buffer, sizeof(buffer), "[?{.3e}, ?{.4g}, ?{.2}]", 123456.0, 3.14159265, 2.71828f);
+    CHECK(std::string(buffer) == "[1.235e+05, 3.142, 2.7]");
+}
+
+TEST_CASE("should print integers with a floating point specifier") {
+    char buffer[128] = { 0 };
+    json_sprint_c(buffer, sizeof(buffer), "[?{.1f}, ?{.1f}]", 3, -2L);
+    CHECK(std::string(buffer) == "[3.0, -2.0]");
+}
+
+TEST_CASE("should print hexadecimal strings with a specifier") {
+    char buffer[128] = { 0 };
+    json_sprint_c(buffer, sizeof(buffer), R"({"id": ?{x}, "ID": ?{X}, "neg": ?{x}})", 48879, 0xDEADBEEFULL, int8_t(-1));
+    CHECK(std::string(buffer) == R"({"id": "beef", "ID": "DEADBEEF", "neg": "ff"})");
+}
+
+TEST_CASE("should print non-finite numbers as null with a specifier") {
+    char buffer[128] = { 0 };
+    json_sprint_c(buffer, sizeof(buffer), "[?{.2f},?{e}]", std::nan(""), -INFINITY);
+    CHECK(std::string(buffer) == "[null,null]");
+}
+
+TEST_CASE("should ignore specifiers for other argument types") {
+    char buffer[128] = { 0 };
+    json_sprint_c(buffer, sizeof(buffer), "[?{.2f}, ?{x}, ?{f}]", "text", true, std::vector<double> { 1.5 });
+    CHECK(std::string(buffer) == R"(["text", true, [1.5]])");
+}
+
+TEST_CASE("should print numbers longer than 128 characters with a specifier") {
+    char expected[256];
+    snprintf(expected, sizeof(expected), "[%.99f]", 1e30);
+    REQUIRE(strlen(expected) == 133);
+    char buffer[256] = { 0 };
+    json_sprint_c(buffer, sizeof(buffer), "[?{.99f}]", 1e30);
+    CHECK(std::string(buffer) == expected);
+
+    auto print = JsonPrint::json_print_resumable(JsonPrint::compile("[?{.99f}]"), 1e30);
+    char piece[16];
+    std::string output;
+    size_t written;
+    while (print.write(piece, sizeof(piece), &written) == JsonPrint::json_print_pending)
+        output.append(piece, written);
+    output.append(piece, written);
+    CHECK(output == expected);
+}
+
+TEST_CASE("should record specifiers at compile-time") {
+    constexpr auto context = JsonPrint::compile("[?, ?{.12f}, ?{X}]");
+    static_assert(context.specs[0].type == 0 && context.specs[0].length == 1, "default placeholder");
+    static_assert(context.specs[1].type == 'f' && context.specs[1].precision == 12 && context.specs[1].length == 7, "fixed");
+    static_assert(context.specs[2].type == 'X' && context.specs[2].length == 4, "hexadecimal");
+    CHECK(context.count == 4);
+}
+
+TEST_CASE("should resume printing after a specifier") {
+    constexpr auto context = JsonPrint::compile("[?{.3f},?{x}]");
+    auto print = JsonPrint::json_print_resumable(context, 1.0, 255);
+    char buffer[4];
+    std::string output;
+    size_t written;
+    while (print.write(buffer, sizeof(buffer), &written) == JsonPrint::json_print_pending)
+        output.append(buffer, written);
+    output.append(buffer, written);
+    CHECK(output == R"([1.000,"ff"])");
+}
+
+TEST_CASE("should not allow invalid specifiers") {
+    CHECK_THROWS(JsonPrint::compile("[?{}]"));
+    CHECK_THROWS(JsonPrint::compile("[?{.f}]"));
+    CHECK_THROWS(JsonPrint::compile("[?{.123f}]"));
+    CHECK_THROWS(JsonPrint::compile("[?{.2x}]"));
+    CHECK_THROWS(JsonPrint::compile("[?{d}]"));
+    CHECK_THROWS(JsonPrint::compile("[?{.2f]"));
+    CHECK_THROWS(JsonPrint::compile("[?{.2"));
+}
@@ -0,0 +1,83 @@
+#include "doctest/doctest.h"
+#include "../src/json_print.hpp"
+#include <utility>
+
+TEST_CASE("should spread map members after other members") {
+    char buffer[128] = { 0 };
+    std::map<std::string, int> extra = { { "a", 1 }, { "b", 2 } };
+    json_sprint_c(buffer, sizeof(buffer), R"({"ts": ?, ...?})", 5, extra);
+    CHECK(std::string(buffer) == R"({"ts": 5,"a":1,"b":2})");
+
+    json_sprint_c(buffer, sizeof(buffer), R"({"ts": ?, ...?})", 5, std::map<std::string, int> {});
+    CHECK(std::string(buffer) == R"({"ts": 5})");
+}
+
+TEST_CASE("should spread map members before other members") {
+    char buffer[128] = { 0 };
+    std::map<std::string, int> extra = { { "a", 1 } };
+    json_sprint_c(buffer, sizeof(buffer), R"({ ...?, "ts": ? })", extra, 5);
+    CHECK(std::string(buffer) == R"({ "a":1,"ts": 5 })");
+
+    json_sprint_c(buffer, sizeof(buffer), R"({ ...?, "ts": ? })", std::map<std::string, int> {}, 5);
+    CHECK(std::string(buffer) == R"({ "ts": 5 })");
+}
+
+TEST_CASE("should spread members between other members and alone") {
+    char buffer[128] = { 0 };
+    std::map<std::string, bool> empty;
+    std::map<std::string, bool> flags = { { "x", true }, { "y", false } };
+    json_sprint_c(buffer, sizeof(buffer), R"({"a": 1, ...?, "b": 2})", flags);
+    CHECK(std::string(buffer) == R"({"a": 1,"x":true,"y":false, "b": 2})");
+    json_sprint_c(buffer, sizeof(buffer), R"({"a": 1, ...?, "b": 2})", empty);
+    CHECK(std::string(buffer) == R"({"a": 1, "b": 2})");
+    json_sprint_c(buffer, sizeof(buffer), "{...?}", flags);
+    CHECK(std::string(buffer) == R"({"x":true,"y":false})");
+    json_sprint_c(buffer, sizeof(buffer), "{...?}", empty);
+    CHECK(std::string(buffer) == "{}");
+    json_sprint_c(buffer, sizeof(buffer), R"({"a": 1, ...?, ...?})", empty, flags);
+    CHECK(std::string(buffer) == R"({"a": 1,"x":true,"y":false})");
+}
+
+TEST_CASE("should spread a range of pairs without a container") {
+    char buffer[128] = { 0 };
+    std::pair<const char*, double> fields[] = { { "cpu", 0.5 }, { "mem", 0.25 } };
+    json_sprint_c(buffer, sizeof(buffer), R"({"host": ?, ...?})", "web-1", JsonPrint::json_range(fields, fields + 2));
+    CHECK(std::string(buffer) == R"({"host": "web-1","cpu":0.5,"mem":0.25})");
+}
+
+TEST_CASE("should print pairs as arrays outside of spread placeholders") {
+    char buffer[128] = { 0 };
+    std::vector<std::pair<std::string, int>> pairs = { { "a", 1 }, { "b", 2 } };
+    json_sprint_c(buffer, sizeof(buffer), "?", pairs);
+    CHECK(std::string(buffer) == R"([["a",1],["b",2]])");
+    json_sprint_c(buffer, sizeof(buffer), "{...?}", pairs);
+    CHECK(std::string(buffer) == R"({"a":1,"b":2})");
+}
+
+TEST_CASE("should validate spread placeholders") {
+    constexpr auto context = JsonPrint::compile(R"({"a": ?, ...?})");
+    CHECK(context.count == 3);
+    CHECK(context.specs[1].type == 's');
+    CHECK_THROWS(JsonPrint::compile(std::string("[...?]").c_str(), std::string("[...?]").c_str() + 6));
+    const char* invalid[] = { "{..?}", "{...?: 1}", R"({...?, ...?, "a": 1})", "{...? ...?}", R"({"a": 1, })", R"({"a": 1, ...?,})" };
+    for (const char* format : invalid)
+        CHECK_THROWS(JsonPrint::compile(format, format + strlen(format)));
+}
+
+TEST_CASE("should reject arguments that can't be spread") {
+    // constant format strings are checked at compile-time by the printing macros
+    static_assert(!JsonPrint::detail::spreads_match<int>(JsonPrint::compile("{...?}")), "");
+    static_assert(!JsonPrint::detail::spreads_match<int, std::vector<std::pair<double, bool>>>(JsonPrint::compile(R"({"ts": ?, ...?})")), "");
+    static_assert(!JsonPrint::detail::spreads_match<const char(&)[2]>(JsonPrint::compile("{...?}")), "");
+    static_assert(JsonPrint::detail::spreads_match<std::map<std::string, int>&, int>(JsonPrint::compile(R"({...?, "ts": ?})")), "");
+    static_assert(JsonPrint::detail::spreads_match<int>(JsonPrint::compile("[?]")), "");
+    static_assert(JsonPrint::detail::spreads_match<>(JsonPrint::compile("{...?}")), "");
+
+    // and format strings compiled at run-time when printing
+    const char format[] = R"({"ts": 1, ...?})";
+    JsonPrint::json_print_context context = JsonPrint::compile(format, format + sizeof(format));
+    char buffer[32];
+    CHECK_THROWS(JsonPrint::json_sprint(buffer, sizeof(buffer), context, 1));
+    std::vector<std::pair<double, bool>> numbered = { { 1.5, true } };
+    CHECK_THROWS(JsonPrint::json_sprint(buffer, sizeof(buffer), context, numbered));
+}
@@ -0,0 +1,42 @@
+#include "doctest/doctest.h"
+#include "../src/json_print.hpp"
+
+TEST_CASE("should print a literal with a template argument format") {
+    char buffer[128];
+    JsonPrint::sprint<R"({"hello": "world"})">(buffer, sizeof(buffer));
+    CHECK(std::string(buffer) == R"({"hello": "world"})");
+}
+
+TEST_CASE("should print placeholders with a template argument format") {
+    char buffer[128];
+    JsonPrint::sprint<R"({"a": ?, "b": [?, ?]})">(buffer, sizeof(buffer), 42, "x", std::vector<int> { 1, 2 });
+    CHECK(std::string(buffer) == R"({"a": 42, "b": ["x", [1,2]]})");
+}
+
+TEST_CASE("should print adjacent placeholders with a template argument format") {
+    char buffer[128];
+    JsonPrint::sprint<"[?,?]">(buffer, sizeof(buffer), true, nullptr);
+    CHECK(std::string(buffer) == "[true,null]");
+}
+
+TEST_CASE("should print sub-templates with a template argument format") {
+    char buffer[128];
+    constexpr auto inner = JsonPrint::compile("[?]");
+    JsonPrint::sprint<R"({"inner": ?})">(buffer, sizeof(buffer), JsonPrint::json_template(inner, 1));
+    CHECK(std::string(buffer) == R"({"inner": [1]})");
+}
+
+TEST_CASE("should count placeholders of a template argument format at compile-time") {
+    static_assert(JsonPrint::detail::static_format<"[?, ?, 1]">::placeholders == 2);
+    static_assert(JsonPrint::detail::static_format<"[?, ?, 1]">::part_size<2> == 4);
+}
+
+TEST_CASE("print compiles without errors") {
+    JsonPrint::print<"[?, 42]\n">("hello");
+}
+
+TEST_CASE("should print specifiers with a template argument format") {
+    char buffer[128];
+    JsonPrint::sprint<"[?{.2f}, ?{x}, ?]">(buffer, sizeof(buffer), 1.0 / 3, 255, 1);
+    CHECK(std::string(buffer) == R"([0.33, "ff", 1])");
+}
@@ -0,0 +1,63 @@
+#define JP_STATS
+#include "doctest/doctest.h"
+#include "../src/json_print.hpp"
+#include "../src/json_print_stats.hpp"
+
+static const JsonPrint::json_print_site_stats* find_site(int line) {
+    for (const JsonPrint::json_print_site_stats* site = JsonPrint::json_print_sites(); site != nullptr; site = site->next) {
+        if (site->line == line && strstr(site->file, "test_stats.cpp") != nullptr)
+            return site;
+    }
+    return nullptr;
+}
+
+TEST_CASE("should record calls and bytes for each call site") {
+    char buffer[128];
+    int line = __LINE__ + 2;
+    for (int i = 0; i < 3; i++)
+        json_sprint_c(buffer, sizeof(buffer), R"({"i": ?})", i);
+    const JsonPrint::json_print_site_stats* site = find_site(line);
+    REQUIRE(site != nullptr);
+    CHECK(std::string(site->format) == R"({"i": ?})");
+    CHECK(site->calls == 3);
+    CHECK(site->bytes == 3 * strlen(R"({"i": 0})"));
+
+    unsigned long long histogram_calls = 0;
+    for (const auto& bucket : site->histogram)
+        histogram_calls += bucket;
+    CHECK(histogram_calls == 3);
+}
+
+TEST_CASE("should record separate call sites separately") {
+    char buffer[128];
+    int line = __LINE__ + 1;
+    json_sprint_c(buffer, sizeof(buffer), "[?]", "a"); json_sprint_c(buffer, sizeof(buffer), "?", "a");
+    const JsonPrint::json_print_site_stats* site = find_site(line);
+    REQUIRE(site != nullptr);
+    CHECK(site->calls == 1);
+    CHECK(site->next != nullptr);
+}
+
+TEST_CASE("should still print when recording statistics") {
+    char buffer[128];
+    json_sprint_c(buffer, sizeof(buffer), "[?, ?]", 1, "two");
+    CHECK(std::string(buffer) == R"([1, "two"])");
+}
+
+TEST_CASE("should dump statistics as JSON") {
+    char buffer[128];
+    int line = __LINE__ + 1;
+    json_sprint_c(buffer, sizeof(buffer), "[?]", true);
+
+    FILE* file = tmpfile();
+    JsonPrint::json_fprint_stats(file);
+    std::string text(ftell(file), '\0');
+    rewind(file);
+    CHECK(fread(&text[0], 1, text.size(), file) == text.size());
+    fclose(file);
+
+    std::string entry = R"(, "line": )" + std::to_string(line) + R"(, "format": "[?]", "calls": 1, "bytes": 6, )";
+    CHECK(text.front() == '[');
+    CHECK(text.find(entry) != std::string::npos);
+    CHECK(text.find(R"("histogram": [)") != std::string::npos);
+}
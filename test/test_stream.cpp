@@ -0,0 +1,85 @@
+#include "doctest/doctest.h"
+#include "../src/json_print.hpp"
+#include "../src/json_print_stream.hpp"
+#include <cstdio>
+#include <string>
+
+TEST_CASE("should stream an array of elements") {
+    std::string text;
+    auto stream = JsonPrint::json_stream(&text);
+    constexpr auto row = JsonPrint::compile(R"({"id": ?, "name": ?})");
+    stream.begin_array();
+    CHECK(!stream.complete());
+    for (int i = 0; i < 3; i++)
+        stream.element(row, i, "row " + std::to_string(i));
+    stream.end_array();
+    CHECK(stream.complete());
+    CHECK(text == R"([{"id": 0, "name": "row 0"},{"id": 1, "name": "row 1"},{"id": 2, "name": "row 2"}])");
+}
+
+TEST_CASE("should stream nested arrays and objects") {
+    std::string text;
+    JsonPrint::json_stream_writer<std::string*> stream(&text);
+    constexpr auto value = JsonPrint::compile("?");
+    stream.begin_object();
+    stream.member("count", value, 2);
+    stream.begin_array("items");
+    stream.element(value, true);
+    stream.begin_object();
+    stream.member("quote\"d", JsonPrint::compile("[1, 2]"));
+    stream.end_object();
+    stream.begin_array();
+    stream.end_array();
+    stream.end_array();
+    CHECK(stream.open() == 1);
+    stream.begin_object("empty");
+    stream.end_object();
+    stream.end_object();
+    CHECK(stream.complete());
+    CHECK(text == R"({"count":2,"items":[true,{"quote\"d":[1, 2]},[]],"empty":{}})");
+}
+
+TEST_CASE("should stream to a file") {
+    FILE* file = tmpfile();
+    REQUIRE(file != nullptr);
+    auto stream = JsonPrint::json_stream(file);
+    stream.begin_array();
+    for (int i = 0; i < 1000; i++)
+        stream.element(JsonPrint::compile("?"), i);
+    stream.end_array();
+    std::string text(8192, '\0');
+    rewind(file);
+    text.resize(fread(&text[0], 1, text.size(), file));
+    fclose(file);
+    CHECK(text.size() == 2 + 10 + 90 * 2 + 900 * 3 + 999);
+    CHECK(text.substr(0, 6) == "[0,1,2");
+}
+
+TEST_CASE("should reject calls that would print invalid JSON") {
+    std::string text;
+    constexpr auto value = JsonPrint::compile("?");
+    auto stream = JsonPrint::json_stream(&text);
+    CHECK_THROWS(stream.end_array());
+    CHECK_THROWS(stream.member("a", value, 1));
+    stream.begin_object();
+    CHECK_THROWS(stream.element(value, 1));
+    CHECK_THROWS(stream.begin_array());
+    CHECK_THROWS(stream.end_array());
+    stream.begin_array("a");
+    CHECK_THROWS(stream.member("b", value, 1));
+    CHECK_THROWS(stream.end_object());
+    CHECK_THROWS(stream.element(value));
+    stream.element(value, 1);
+    stream.end_array();
+    CHECK_THROWS(stream.member("b", value));
+    stream.member("c", value, 2);
+    stream.end_object();
+    CHECK_THROWS(stream.begin_array());
+    CHECK(text == R"({"a":[1],"c":2})");
+
+    std::string deep;
+    auto nested = JsonPrint::json_stream(&deep);
+    for (int i = 0; i < JP_MAX_STREAM_DEPTH; i++)
+        nested.begin_array();
+    CHECK_THROWS(nested.begin_array());
+}
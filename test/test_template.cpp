@@ -0,0 +1,83 @@
+#include "doctest/doctest.h"
+#include "../src/json_print.hpp"
+
+TEST_CASE("should print a sub-template") {
+    char buffer[128] = { 0 };
+    const char format[] = R"({"inner": ?})";
+    const char inner_format[] = R"({"a": ?, "b": ?})";
+    JsonPrint::json_print_context context = JsonPrint::compile(format, format + sizeof(format));
+    JsonPrint::json_print_context inner = JsonPrint::compile(inner_format, inner_format + sizeof(inner_format));
+    json_sprint(buffer, sizeof(buffer), context, JsonPrint::json_template(inner, 42, "x"));
+    CHECK(std::string(buffer) == R"({"inner": {"a": 42, "b": "x"}})");
+}
+
+TEST_CASE("should print a sub-template without placeholders") {
+    char buffer[128] = { 0 };
+    const char format[] = "[?,?]";
+    const char inner_format[] = "[]";
+    JsonPrint::json_print_context context = JsonPrint::compile(format, format + sizeof(format));
+    JsonPrint::json_print_context inner = JsonPrint::compile(inner_format, inner_format + sizeof(inner_format));
+    json_sprint(buffer, sizeof(buffer), context, JsonPrint::json_template(inner), 1);
+    CHECK(std::string(buffer) == "[[],1]");
+}
+
+TEST_CASE("should print nested sub-templates") {
+    char buffer[128] = { 0 };
+    const char format[] = "[?]";
+    JsonPrint::json_print_context context = JsonPrint::compile(format, format + sizeof(format));
+    json_sprint(buffer, sizeof(buffer), context, 
+        JsonPrint::json_template(context, JsonPrint::json_template(context, std::string("deep"))));
+    CHECK(std::string(buffer) == R"([[["deep"]]])");
+}
+
+TEST_CASE("should print a compile-time validated sub-template") {
+    char buffer[128] = { 0 };
+    std::string name = "John";
+    json_sprint_c(buffer, sizeof(buffer), R"({"person": ?})", json_template_c(R"({"name": ?, "age": ?})", name, 42));
+    CHECK(std::string(buffer) == R"({"person": {"name": "John", "age": 42}})");
+}
+
+TEST_CASE("should print an array of objects from a row template") {
+    struct row { int id; const char* name; };
+    std::vector<row> rows = { { 1, "a" }, { 2, "b" } };
+    char buffer[128] = { 0 };
+    constexpr auto row_context = JsonPrint::compile(R"({"id": ?, "name": ?})");
+    json_sprint_c(buffer, sizeof(buffer), R"({"rows": ?})", JsonPrint::json_generator([&](auto emit) {
+        for (const row& r : rows)
+            emit(JsonPrint::json_template(row_context, r.id, r.name));
+    }));
+    CHECK(std::string(buffer) == R"({"rows": [{"id": 1, "name": "a"},{"id": 2, "name": "b"}]})");
+}
+
+TEST_CASE("should print a vector of sub-templates") {
+    char buffer[128] = { 0 };
+    constexpr auto pair_context = JsonPrint::compile("[?,?]");
+    std::vector<decltype(JsonPrint::json_template(pair_context, 0, 0))> pairs;
+    pairs.push_back(JsonPrint::json_template(pair_context, 1, 2));
+    pairs.push_back(JsonPrint::json_template(pair_context, 3, 4));
+    json_sprint_c(buffer, sizeof(buffer), "?", pairs);
+    CHECK(std::string(buffer) == "[[1,2],[3,4]]");
+}
+
+TEST_CASE("should terminate the output instead of printing the format's null terminator") {
+    char buffer[128];
+    memset(buffer, 'x', sizeof(buffer));
+    json_sprint_c(buffer, sizeof(buffer), "[?]", 1);
+    CHECK(std::string(buffer, 3) == "[1]");
+    CHECK(buffer[3] == '\0');
+    CHECK(buffer[4] == 'x');
+}
+
+TEST_CASE("should terminate truncated output") {
+    char buffer[4];
+    json_sprint_c(buffer, sizeof(buffer), "[?]", 12345);
+    CHECK(std::string(buffer) == "[12");
+}
+
+TEST_CASE("should keep a sub-template of a temporary context") {
+    char buffer[128] = { 0 };
+    auto inner = JsonPrint::json_template(JsonPrint::compile(R"({"a": ?})"), 1);
+    std::vector<int> overwrite = { 2, 3, 4 };
+    json_sprint_c(buffer, sizeof(buffer), "[?, ?]", inner, overwrite);
+    CHECK(std::string(buffer) == R"([{"a": 1}, [2,3,4]])");
+}
@@ -0,0 +1,84 @@
+#include "doctest/doctest.h"
+#include "../src/json_print.hpp"
+#include "../src/json_print_uring.hpp"
+#include <sys/socket.h>
+#include <thread>
+
+static std::string read_all(int fd) {
+    std::string data;
+    char buffer[4096];
+    for (ssize_t size; (size = read(fd, buffer, sizeof(buffer))) > 0;)
+        data.append(buffer, size);
+    return data;
+}
+
+static std::string print_records(JsonPrint::json_uring_writer& writer, int count) {
+    std::string expected;
+    constexpr auto context = JsonPrint::compile("{\"i\": ?, \"text\": ?}\n");
+    for (int i = 0; i < count; i++) {
+        std::string text(i % 50, 'a' + i % 26);
+        JsonPrint::json_uring_print(writer, context, i, text);
+        expected += "{\"i\": " + std::to_string(i) + ", \"text\": \"" + text + "\"}\n";
+    }
+    return expected;
+}
+
+TEST_CASE("should write records to a file with io_uring") {
+    FILE* file = tmpfile();
+    {
+        JsonPrint::json_uring_writer writer(fileno(file));
+        json_uring_print_c(writer, R"({"id": ?, "name": ?})", 1, "first");
+        json_uring_print_c(writer, "[?]", std::vector<double> { 1.5, 2.5 });
+        writer.flush();
+        CHECK(writer.written() == 37);
+    }
+    // the file position is moved past the records
+    CHECK(lseek(fileno(file), 0, SEEK_CUR) == 37);
+    lseek(fileno(file), 0, SEEK_SET);
+    CHECK(read_all(fileno(file)) == R"({"id": 1, "name": "first"}[[1.5,2.5]])");
+    fclose(file);
+}
+
+TEST_CASE("should keep records in order with many buffers in flight") {
+    FILE* file = tmpfile();
+    JsonPrint::json_uring_options options;
+    options.buffer_size = 256;
+    options.buffers = 8;
+    std::string expected;
+    {
+        JsonPrint::json_uring_writer writer(fileno(file), options);
+        expected = print_records(writer, 10000);
+    }
+    lseek(fileno(file), 0, SEEK_SET);
+    CHECK(read_all(fileno(file)) == expected);
+    fclose(file);
+}
+
+TEST_CASE("should write to a socket one buffer at a time") {
+    int fds[2];
+    REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    std::string received;
+    std::thread reader([&]() { received = read_all(fds[0]); });
+    JsonPrint::json_uring_options options;
+    options.buffer_size = 1024;
+    std::string expected;
+    {
+        JsonPrint::json_uring_writer writer(fds[1], options);
+        expected = print_records(writer, 10000);
+    }
+    close(fds[1]);
+    reader.join();
+    close(fds[0]);
+    CHECK(received.size() == expected.size());
+    CHECK(received == expected);
+}
+
+TEST_CASE("should throw when the file descriptor can't be written") {
+    int fds[2];
+    REQUIRE(pipe(fds) == 0);
+    JsonPrint::json_uring_writer writer(fds[0]);
+    json_uring_print_c(writer, "[?]", 1);
+    CHECK_THROWS(writer.flush());
+    close(fds[0]);
+    close(fds[1]);
+}
@@ -0,0 +1,87 @@
+#include "doctest/doctest.h"
+#include "../src/json_print.hpp"
+#include <memory>
+
+template <int Utf8Policy, bool AsciiOnly = false>
+static std::string print_string(const std::string& text) {
+    char buffer[256] = { 0 };
+    JsonPrint::detail::string_buffer sbuffer = { buffer, buffer + sizeof(buffer) - 1 };
+    JsonPrint::detail::json_print_string<Utf8Policy, AsciiOnly>(&sbuffer, text.data(), text.data() + text.size());
+    return buffer;
+}
+
+TEST_CASE("should escape control characters as \\u escapes") {
+    CHECK(print_string<JP_UTF8_PASSTHROUGH>(std::string("a\x01" "b\x1f", 4)) == R"("a\u0001b\u001f")");
+}
+
+TEST_CASE("should escape special characters found after a long plain run") {
+    CHECK(print_string<JP_UTF8_PASSTHROUGH>("0123456789abcdef\"0123456789\\x\n") == R"("0123456789abcdef\"0123456789\\x\n")");
+}
+
+TEST_CASE("should pass UTF-8 through by default") {
+    CHECK(print_string<JP_UTF8_PASSTHROUGH>(u8"caf\u00e9 \u3053\u3093") == u8"\"caf\u00e9 \u3053\u3093\"");
+    CHECK(print_string<JP_UTF8_PASSTHROUGH>("bad\xff") == "\"bad\xff\"");
+}
+
+TEST_CASE("should keep valid UTF-8 with every policy") {
+    std::string text = u8"\u00e9\u0800\uffff\U0001F600 long enough to be checked a word at a time \u00e9";
+    CHECK(print_string<JP_UTF8_REPLACE>(text) == "\"" + text + "\"");
+    CHECK(print_string<JP_UTF8_ESCAPE>(text) == "\"" + text + "\"");
+    CHECK(print_string<JP_UTF8_REJECT>(text) == "\"" + text + "\"");
+}
+
+TEST_CASE("should replace invalid UTF-8 with U+FFFD") {
+    CHECK(print_string<JP_UTF8_REPLACE>("a\xff" "b") == "\"a\xEF\xBF\xBD" "b\"");
+    // truncated sequence at the end of the string
+    CHECK(print_string<JP_UTF8_REPLACE>("a\xe3\x81") == "\"a\xEF\xBF\xBD\"");
+    // overlong encoding of '/'
+    CHECK(print_string<JP_UTF8_REPLACE>("\xc0\xaf") == "\"\xEF\xBF\xBD\xEF\xBF\xBD\"");
+    // encoded surrogate
+    CHECK(print_string<JP_UTF8_REPLACE>("\xed\xa0\x80") == "\"\xEF\xBF\xBD\xEF\xBF\xBD\xEF\xBF\xBD\"");
+}
+
+TEST_CASE("should escape invalid UTF-8 bytes") {
+    CHECK(print_string<JP_UTF8_ESCAPE>("a\xff" "b") == R"("a\u00ffb")");
+    CHECK(print_string<JP_UTF8_ESCAPE>("\xe3\x81" "a") == R"("\u00e3\u0081a")");
+}
+
+TEST_CASE("should reject invalid UTF-8") {
+    CHECK_THROWS(print_string<JP_UTF8_REJECT>("a\xff"));
+    CHECK_THROWS(print_string<JP_UTF8_REJECT>("\xf4\x90\x80\x80"));
+}
+
+TEST_CASE("should print non-ASCII characters as \\u escapes in ASCII-only mode") {
+    CHECK(print_string<JP_UTF8_PASSTHROUGH, true>(u8"caf\u00e9") == R"("caf\u00e9")");
+    CHECK(print_string<JP_UTF8_PASSTHROUGH, true>(u8"\u3053\u3093") == R"("\u3053\u3093")");
+}
+
+TEST_CASE("should print surrogate pairs in ASCII-only mode") {
+    CHECK(print_string<JP_UTF8_PASSTHROUGH, true>(u8"\U0001F600") == R"("\ud83d\ude00")");
+    CHECK(print_string<JP_UTF8_PASSTHROUGH, true>(u8"\U0010FFFF") == R"("\udbff\udfff")");
+}
+
+TEST_CASE("should replace invalid UTF-8 in ASCII-only mode") {
+    CHECK(print_string<JP_UTF8_REPLACE, true>("a\xff") == R"("a\ufffd")");
+    CHECK(print_string<JP_UTF8_PASSTHROUGH, true>("a\xff") == R"("a\u00ff")");
+}
+
+
+TEST_CASE("should not read past the end of a truncated sequence") {
+    // the continuation byte after the end belongs to other text
+    char buffer[32] = { 0 };
+    std::unique_ptr<char[]> text(new char[2] { 'a', '\xc3' });
+    json_sprint_c(buffer, sizeof(buffer), "?", JsonPrint::json_string<JP_UTF8_REPLACE>(text.get(), text.get() + 2));
+    CHECK(std::string(buffer) == "\"a\xEF\xBF\xBD\"");
+    const char bytes[] = "a\xc3\xa9";
+    json_sprint_c(buffer, sizeof(buffer), "?", JsonPrint::json_string<JP_UTF8_ESCAPE>(bytes, bytes + 2));
+    CHECK(std::string(buffer) == R"("a\u00c3")");
+}
+
+TEST_CASE("should print a string argument with its own policy") {
+    char buffer[64] = { 0 };
+    std::string text = u8"caf\u00e9\xff";
+    json_sprint_c(buffer, sizeof(buffer), "[?, ?, ?]", JsonPrint::json_string<JP_UTF8_REPLACE, true>(text), 
+        JsonPrint::json_string<JP_UTF8_ESCAPE>(text), JsonPrint::json_string<JP_UTF8_PASSTHROUGH>("x"));
+    CHECK(std::string(buffer) == "[\"caf\\u00e9\\ufffd\", \"caf\u00e9\\u00ff\", \"x\"]");
+    CHECK_THROWS(json_sprint_c(buffer, sizeof(buffer), "?", JsonPrint::json_string<JP_UTF8_REJECT>(text)));
+}
@@ -0,0 +1,99 @@
+#include "doctest/doctest.h"
+#include "../src/json_print.hpp"
+#include "../src/json_print_zlib.hpp"
+
+static std::string read_file(FILE* file) {
+    std::string data(ftell(file), '\0');
+    rewind(file);
+    if (!data.empty())
+        CHECK(fread(&data[0], 1, data.size(), file) == data.size());
+    return data;
+}
+
+static std::string decompress(const std::string& data, bool gzip = true) {
+    z_stream stream = z_stream();
+    REQUIRE(inflateInit2(&stream, gzip ? 15 + 16 : 15) == Z_OK);
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    std::string result;
+    char buffer[4096];
+    int status = Z_OK;
+    while (status == Z_OK) {
+        stream.next_out = reinterpret_cast<Bytef*>(buffer);
+        stream.avail_out = sizeof(buffer);
+        status = inflate(&stream, Z_NO_FLUSH);
+        result.append(buffer, sizeof(buffer) - stream.avail_out);
+    }
+    CHECK(status == Z_STREAM_END);
+    inflateEnd(&stream);
+    return result;
+}
+
+TEST_CASE("should write a gzip stream that decompresses to the printed text") {
+    FILE* file = tmpfile();
+    {
+        JsonPrint::json_gzip_writer writer(file);
+        json_gzprint_c(writer, R"({"id": ?, "name": ?})", 1, "first");
+        json_gzprint_c(writer, "[?]", std::vector<double> { 1.5, 2.5 });
+    }
+    CHECK(decompress(read_file(file)) == R"({"id": 1, "name": "first"}[[1.5,2.5]])");
+    fclose(file);
+}
+
+TEST_CASE("should compress many records through small buffers") {
+    FILE* file = tmpfile();
+    std::string expected;
+    JsonPrint::json_gzip_options options;
+    options.buffer_size = 256;
+    options.level = 9;
+    constexpr auto context = JsonPrint::compile("{\"i\": ?, \"text\": ?}\n");
+    {
+        JsonPrint::json_gzip_writer writer(file, options);
+        for (int i = 0; i < 10000; i++) {
+            std::string text = "record " + std::to_string(i * 7919);
+            JsonPrint::json_gzprint(writer, context, i, text);
+            expected += "{\"i\": " + std::to_string(i) + ", \"text\": \"" + text + "\"}\n";
+        }
+        writer.close();
+        CHECK(writer.total_in() == expected.size());
+        CHECK(writer.total_out() < expected.size() / 2);
+    }
+    CHECK(decompress(read_file(file)) == expected);
+    fclose(file);
+}
+
+TEST_CASE("should make each record readable when flushing per record") {
+    FILE* file = tmpfile();
+    JsonPrint::json_gzip_options options;
+    options.gzip = false;
+    options.flush = JsonPrint::json_gzip_flush_record;
+    JsonPrint::json_gzip_writer writer(file, options);
+    json_gzprint_c(writer, "[?]", 42);
+
+    // decompress what has been written before the stream is finished
+    std::string data = read_file(file);
+    z_stream stream = z_stream();
+    REQUIRE(inflateInit(&stream) == Z_OK);
+    char buffer[64];
+    stream.next_in = reinterpret_cast<Bytef*>(&data[0]);
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef*>(buffer);
+    stream.avail_out = sizeof(buffer);
+    CHECK(inflate(&stream, Z_SYNC_FLUSH) == Z_OK);
+    CHECK(std::string(buffer, sizeof(buffer) - stream.avail_out) == "[42]");
+    inflateEnd(&stream);
+
+    writer.close();
+    fclose(file);
+}
+
+TEST_CASE("should write a compressed stream to a file descriptor") {
+    FILE* file = tmpfile();
+    {
+        JsonPrint::json_gzip_writer writer(fileno(file));
+        json_gzprint_c(writer, "?", "hello");
+    }
+    fseek(file, 0, SEEK_END);
+    CHECK(decompress(read_file(file)) == R"("hello")");
+    fclose(file);
+}